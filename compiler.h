@@ -218,6 +218,10 @@ extern int lexor_keyword_mask;
   /* This is the string to use to invoke the preprocessor. */
 extern char*ivlpp_string;
 
+  /* If not nil, this is a directory where the preprocessed text of
+     library files is cached between compiles. */
+extern const char*library_cache_dir;
+
 extern map<perm_string,unsigned> missing_modules;
 
   /* Files that are library files are in this map. The lexor compares
@@ -21,6 +21,7 @@
 
 # include  <algorithm>
 # include  <vector>
+# include  <set>
 # include  <cstdlib>
 # include  "netlist.h"
 # include  "netmisc.h"
@@ -34,13 +35,24 @@
  * possible. The elaboration generates NetConst objects. I can remove
  * these and replace the gates connected to it with simpler ones. I
  * may even be able to replace nets with a new constant.
+ *
+ * The first pass scans all the nodes of the design. After that, the
+ * nodes connected to anything that an optimization changed are put on
+ * a work list, and only the nodes of the work list are scanned again.
  */
 
 struct cprop_functor  : public functor_t {
 
+      cprop_functor() { scan_mask = SCAN_NODES; }
+
       unsigned count;
 
-      virtual void signal(Design*des, NetNet*obj);
+	// Scan the nodes that are on the work list. Nodes that are
+	// added to the work list by the scan are left for the next
+	// call. Return the number of nodes scanned.
+      unsigned run_work_list(Design*des);
+      bool work_pending() const { return ! work_list_.empty(); }
+
       virtual void lpm_add_sub(Design*des, NetAddSub*obj);
       virtual void lpm_compare(Design*des, NetCompare*obj);
       virtual void lpm_concat(Design*des, NetConcat*obj);
@@ -50,10 +62,55 @@ struct cprop_functor  : public functor_t {
       virtual void lpm_part_select(Design*des, NetPartSelect*obj);
 
       void lpm_compare_eq_(Design*des, NetCompare*obj);
+
+    private:
+      void enqueue_nexus_(Nexus*nex);
+      void delete_node_(NetNode*obj);
+
+	// These are the nodes to scan again. The set keeps the list
+	// unique, and a node that is deleted is removed from the set
+	// so that the stale list entry is skipped.
+      std::vector<NetNode*> work_list_;
+      std::set<NetNode*> work_set_;
  };
 
-void cprop_functor::signal(Design*, NetNet*)
+/*
+ * Put all the nodes connected to the nexus on the work list. A change
+ * to the drivers of a nexus can only make new optimizations possible
+ * for the nodes connected to it.
+ */
+void cprop_functor::enqueue_nexus_(Nexus*nex)
+{
+      for (Link*cur = nex->first_nlink() ; cur ; cur = cur->next_nlink()) {
+	    NetNode*node = dynamic_cast<NetNode*> (cur->get_obj());
+	    if (node == 0)
+		  continue;
+	    if (work_set_.insert(node).second)
+		  work_list_.push_back(node);
+      }
+}
+
+void cprop_functor::delete_node_(NetNode*obj)
+{
+      work_set_.erase(obj);
+      delete obj;
+}
+
+unsigned cprop_functor::run_work_list(Design*des)
 {
+      std::vector<NetNode*> cur;
+      cur.swap(work_list_);
+
+      unsigned scanned = 0;
+      for (size_t idx = 0 ; idx < cur.size() ; idx += 1) {
+	    if (work_set_.erase(cur[idx]) == 0)
+		  continue;
+
+	    cur[idx]->functor_node(des, this);
+	    scanned += 1;
+      }
+
+      return scanned;
 }
 
 void cprop_functor::lpm_add_sub(Design*, NetAddSub*)
@@ -117,7 +174,8 @@ void cprop_functor::lpm_concat(Design*des, NetConcat*obj)
 
 	// Note that this will leave the const inputs to dangle. They
 	// will be reaped by other passes of cprop_functor.
-      delete obj;
+      delete_node_(obj);
+      enqueue_nexus_(result_obj->pin(0).nexus());
 
       count += 1;
 }
@@ -133,9 +191,10 @@ void cprop_functor::lpm_ff(Design*, NetFF*obj)
 	  && (! obj->pin_Sset().is_linked())
 	  && (! obj->pin_Aclr().is_linked())
 	  && (! obj->pin_Aset().is_linked())) {
+	    enqueue_nexus_(obj->pin_Q().nexus());
 	    obj->pin_Data().unlink();
 	    obj->pin_Q().unlink();
-	    delete obj;
+	    delete_node_(obj);
       }
 }
 
@@ -193,8 +252,9 @@ void cprop_functor::lpm_mux(Design*des, NetMux*obj)
 	    connect(tmp->pin(1), obj->pin_Data(1));
       else
 	    connect(tmp->pin(1), obj->pin_Data(0));
-      delete obj;
+      delete_node_(obj);
       des->add_node(tmp);
+      enqueue_nexus_(tmp->pin(0).nexus());
       count += 1;
 }
 
@@ -328,9 +388,12 @@ void cprop_functor::lpm_part_select(Design*des, NetPartSelect*obj)
       ivl_assert(*obj, concat_pin == concat->pin_count());
 
       for (size_t idx = 0 ; idx < obj_set.size() ; idx += 1) {
-	    delete obj_set[idx];
+	    delete_node_(obj_set[idx]);
       }
 
+	// The new concatenation may itself be constant.
+      enqueue_nexus_(concat->pin(0).nexus());
+
       count += 1;
 }
 
@@ -342,6 +405,8 @@ void cprop_functor::lpm_part_select(Design*des, NetPartSelect*obj)
  */
 struct cprop_dc_functor  : public functor_t {
 
+      cprop_dc_functor() { scan_mask = SCAN_NODES; }
+
       virtual void lpm_const(Design*des, NetConst*obj);
 };
 
@@ -433,17 +498,26 @@ void cprop_dc_functor::lpm_const(Design*, NetConst*obj)
 
 void cprop(Design*des)
 {
-	// Continually propagate constants until a scan finds nothing
-	// to do.
+	// Scan the whole design once, then continually propagate
+	// constants through the nodes connected to whatever changed
+	// until the work list is empty.
       cprop_functor prop;
-      do {
+      prop.count = 0;
+      des->functor(&prop);
+      if (verbose_flag) {
+	    cout << " ... Iteration detected "
+		 << prop.count << " optimizations." << endl << flush;
+      }
+
+      while (prop.work_pending()) {
 	    prop.count = 0;
-	    des->functor(&prop);
+	    unsigned scanned = prop.run_work_list(des);
 	    if (verbose_flag) {
-		  cout << " ... Iteration detected "
-		       << prop.count << " optimizations." << endl << flush;
+		  cout << " ... Iteration scanned " << scanned << " nodes and"
+		       << " detected " << prop.count << " optimizations."
+		       << endl << flush;
 	    }
-      } while (prop.count > 0);
+      }
 
       if (verbose_flag) {
 	    cout << " ... Look for dangling constants" << endl << flush;
@@ -394,6 +394,141 @@ static int t_preprocess_only(void)
       return 0;
 }
 
+#ifndef __MINGW32__
+/*
+ * Print the argument lists of the compile pipeline, in the form of
+ * the shell command that they replace.
+ */
+static void print_pipeline(FILE*fd, char*const pp_argv[],
+			   char*const ivl_argv[])
+{
+      int idx;
+
+      for (idx = 0 ; pp_argv[idx] ; idx += 1)
+	    fprintf(fd, "%s%s", idx? " " : "", pp_argv[idx]);
+      fprintf(fd, " |");
+      for (idx = 0 ; ivl_argv[idx] ; idx += 1)
+	    fprintf(fd, " %s", ivl_argv[idx]);
+      fprintf(fd, "\n");
+}
+
+/*
+ * Start the preprocessor and the compiler directly, connected by a
+ * pipe, instead of asking a shell to run the command line. This saves
+ * starting a shell for every compile, which is noticeable when many
+ * small designs are compiled. The result is the exit code for the
+ * driver, and a failure is reported with the commands that were run.
+ */
+static int run_compile_pipeline(void)
+{
+      char ivlpp_path[MAXSIZE], ivl_path[MAXSIZE];
+      char def_arg[MAXSIZE], src_arg[MAXSIZE], pre_arg[MAXSIZE];
+      char net_arg[MAXSIZE], cfg_arg[MAXSIZE];
+      char com_arg[sizeof iconfig_common_path + 2];
+      char*pp_argv[8];
+      char*ivl_argv[9];
+      int npp = 0, nivl = 0;
+      int fds[2];
+      pid_t pp_pid, ivl_pid;
+      int pp_status, ivl_status;
+      int rc;
+
+      snprintf(ivlpp_path, sizeof ivlpp_path, "%s%civlpp", ivlpp_dir, sep);
+      snprintf(def_arg, sizeof def_arg, "-F%s", defines_path);
+      snprintf(src_arg, sizeof src_arg, "-f%s", source_path);
+      snprintf(pre_arg, sizeof pre_arg, "-p%s", compiled_defines_path);
+      pp_argv[npp++] = ivlpp_path;
+      if (verbose_flag) pp_argv[npp++] = "-v";
+      pp_argv[npp++] = "-L";
+      pp_argv[npp++] = def_arg;
+      pp_argv[npp++] = src_arg;
+      pp_argv[npp++] = pre_arg;
+      pp_argv[npp] = 0;
+
+      snprintf(ivl_path, sizeof ivl_path, "%s%civl", base, sep);
+      snprintf(cfg_arg, sizeof cfg_arg, "-C%s", iconfig_path);
+      snprintf(com_arg, sizeof com_arg, "-C%s", iconfig_common_path);
+      ivl_argv[nivl++] = ivl_path;
+      if (verbose_flag) ivl_argv[nivl++] = "-v";
+      if (npath != 0) {
+	    snprintf(net_arg, sizeof net_arg, "-N%s", npath);
+	    ivl_argv[nivl++] = net_arg;
+      }
+      ivl_argv[nivl++] = cfg_arg;
+      ivl_argv[nivl++] = com_arg;
+      ivl_argv[nivl++] = "--";
+      ivl_argv[nivl++] = "-";
+      ivl_argv[nivl] = 0;
+
+      if (verbose_flag) {
+	    printf("translate: ");
+	    print_pipeline(stdout, pp_argv, ivl_argv);
+      }
+
+      if (pipe(fds) != 0) {
+	    perror("pipe");
+	    rc = 127;
+	    goto failed;
+      }
+
+	/* Do not let the children inherit unwritten output. */
+      fflush(0);
+
+      pp_pid = fork();
+      if (pp_pid == 0) {
+	    dup2(fds[1], 1);
+	    close(fds[0]);
+	    close(fds[1]);
+	    execv(ivlpp_path, pp_argv);
+	    perror(ivlpp_path);
+	    _exit(127);
+      }
+
+      ivl_pid = (pp_pid < 0)? -1 : fork();
+      if (ivl_pid == 0) {
+	    dup2(fds[0], 0);
+	    close(fds[0]);
+	    close(fds[1]);
+	    execv(ivl_path, ivl_argv);
+	    perror(ivl_path);
+	    _exit(127);
+      }
+
+      close(fds[0]);
+      close(fds[1]);
+
+      if (pp_pid < 0 || ivl_pid < 0) {
+	    perror("fork");
+	    if (pp_pid > 0)
+		  waitpid(pp_pid, &pp_status, 0);
+	    rc = 127;
+	    goto failed;
+      }
+
+      while (waitpid(pp_pid, &pp_status, 0) < 0 && errno == EINTR)
+	    ;
+      while (waitpid(ivl_pid, &ivl_status, 0) < 0 && errno == EINTR)
+	    ;
+
+      rc = ivl_status;
+      if (rc == 0)
+	    return 0;
+      if (rc != 127 && WIFEXITED(rc))
+	    return WEXITSTATUS(rc);
+
+ failed:
+      if (rc == 127) {
+	    fprintf(stderr, "Failed to execute: ");
+	    print_pipeline(stderr, pp_argv, ivl_argv);
+	    return 1;
+      }
+
+      fprintf(stderr, "Command signaled: ");
+      print_pipeline(stderr, pp_argv, ivl_argv);
+      return -1;
+}
+#endif
+
 /*
  * This is the default target type. It looks up the bits that are
  * needed to run the command from the configuration file (which is
@@ -401,6 +536,7 @@ static int t_preprocess_only(void)
  */
 static int t_compile()
 {
+#ifdef __MINGW32__
       unsigned rc;
 
 	/* Start by building the preprocess command line. */
@@ -410,10 +546,6 @@ static int t_compile()
       char*cmd = malloc(ncmd + 1);
       strcpy(cmd, tmp);
 
-#ifndef __MINGW32__
-      int rtn;
-#endif
-
 	/* Build the ivl command and pipe it to the preprocessor. */
       snprintf(tmp, sizeof tmp, " | %s%civl", base, sep);
       rc = strlen(tmp);
@@ -455,6 +587,13 @@ static int t_compile()
 
 
       rc = system(cmd);
+#else
+      int rtn;
+
+	/* Run the preprocessor piped into ivl. This reports its own
+	   failures with the commands that it ran. */
+      rtn = run_compile_pipeline();
+#endif
       if ( ! getenv("IVERILOG_ICONFIG")) {
 	    remove(source_path);
 	    free(source_path);
@@ -469,20 +608,6 @@ static int t_compile()
       free(cmd);
       return rc;
 #else
-      rtn = 0;
-      if (rc != 0) {
-	    if (rc == 127) {
-		  fprintf(stderr, "Failed to execute: %s\n", cmd);
-		  rtn = 1;
-	    } else if (WIFEXITED(rc)) {
-		  rtn = WEXITSTATUS(rc);
-	    } else {
-		  fprintf(stderr, "Command signaled: %s\n", cmd);
-		  rtn = -1;
-	    }
-      }
-
-      free(cmd);
       return rtn;
 #endif
 }
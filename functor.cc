@@ -26,6 +26,11 @@
 
 using namespace std;
 
+functor_t::functor_t()
+: scan_mask(SCAN_ALL)
+{
+}
+
 functor_t::~functor_t()
 {
 }
@@ -113,12 +118,17 @@ void NetScope::run_functor(Design*des, functor_t*fun)
 		 ; cur != children_.end() ; ++ cur )
 	    cur->second->run_functor(des, fun);
 
-      for (NetEvent*cur = events_ ;  cur ;  /* */) {
-	    NetEvent*tmp = cur;
-	    cur = cur->snext_;
-	    fun->event(des, tmp);
+      if (fun->scan_mask & functor_t::SCAN_EVENTS) {
+	    for (NetEvent*cur = events_ ;  cur ;  /* */) {
+		  NetEvent*tmp = cur;
+		  cur = cur->snext_;
+		  fun->event(des, tmp);
+	    }
       }
 
+      if (! (fun->scan_mask & functor_t::SCAN_SIGNALS))
+	    return;
+
 	// apply to signals. Each iteration, allow for the possibility
 	// that the current signal deletes itself.
 
@@ -132,21 +142,25 @@ void NetScope::run_functor(Design*des, functor_t*fun)
 
 void Design::functor(functor_t*fun)
 {
-	// Scan the scopes
-      for (list<NetScope*>::const_iterator scope = root_scopes_.begin();
-	   scope != root_scopes_.end(); ++ scope )
-	    (*scope)->run_functor(this, fun);
+	// Scan the scopes, if the functor looks at events or signals.
+      if (fun->scan_mask & (functor_t::SCAN_EVENTS|functor_t::SCAN_SIGNALS)) {
+	    for (list<NetScope*>::const_iterator scope = root_scopes_.begin();
+		 scope != root_scopes_.end(); ++ scope )
+		  (*scope)->run_functor(this, fun);
+      }
 
 	// apply to processes
-      procs_idx_ = procs_;
-      while (procs_idx_) {
-	    NetProcTop*idx = procs_idx_;
-	    procs_idx_ = idx->next_;
-	    fun->process(this, idx);
+      if (fun->scan_mask & functor_t::SCAN_PROCESSES) {
+	    procs_idx_ = procs_;
+	    while (procs_idx_) {
+		  NetProcTop*idx = procs_idx_;
+		  procs_idx_ = idx->next_;
+		  fun->process(this, idx);
+	    }
       }
 
 	// apply to nodes
-      if (nodes_) {
+      if (nodes_ && (fun->scan_mask & functor_t::SCAN_NODES)) {
 	    assert(nodes_functor_cur_ == 0);
 	    assert(nodes_functor_nxt_ == 0);
 
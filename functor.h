@@ -37,8 +37,20 @@ class NetNet;
 class NetProcTop;
 
 struct functor_t {
+      functor_t();
       virtual ~functor_t();
 
+	/* These are the kinds of objects that the Design::functor
+	   method can scan. A functor that only handles some kinds of
+	   objects clears the others from the scan_mask so that the
+	   scan skips those parts of the design entirely. */
+      enum scan_t { SCAN_EVENTS    = 0x01,
+		    SCAN_SIGNALS   = 0x02,
+		    SCAN_PROCESSES = 0x04,
+		    SCAN_NODES     = 0x08,
+		    SCAN_ALL       = 0x0f };
+      unsigned scan_mask;
+
 	/* Events are scanned here. */
       virtual void event(class Design*des, class NetEvent*);
 
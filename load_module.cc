@@ -28,6 +28,8 @@
 # include  <string>
 # include  <sys/types.h>
 # include  <dirent.h>
+# include  <cstdio>
+# include  <set>
 # include  <cctype>
 # include  <cassert>
 # include  "ivl_alloc.h"
@@ -50,6 +52,191 @@ const char dir_character = '/';
 extern char depfile_mode;
 extern FILE *depend_file;
 
+/*
+ * The library cache keeps the preprocessed text of library files in
+ * the directory named by the LIBRARY_CACHE_DIR flag so that later
+ * compiles do not need to run the preprocessor on them again. An
+ * entry is named by a hash of the library file, the preprocessor
+ * command and the contents of the files that the command names (the
+ * defines files). Along with the text, each entry lists the files
+ * that were included while preprocessing with a hash of their
+ * contents, and the entry is only used if none of these changed.
+ */
+static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_PRIME  = 0x100000001b3ULL;
+
+static void hash_bytes(uint64_t&hash, const char*data, size_t len)
+{
+      for (size_t idx = 0 ; idx < len ; idx += 1) {
+	    hash ^= (unsigned char)data[idx];
+	    hash *= FNV_PRIME;
+      }
+}
+
+static bool hash_file(uint64_t&hash, const char*path)
+{
+      FILE*file = fopen(path, "rb");
+      if (file == 0)
+	    return false;
+
+      char buf[16*1024];
+      size_t cnt;
+      while ((cnt = fread(buf, 1, sizeof buf, file)) > 0)
+	    hash_bytes(hash, buf, cnt);
+
+      fclose(file);
+      return true;
+}
+
+static bool library_cache_key(const char*path, uint64_t&key)
+{
+      key = FNV_OFFSET;
+      hash_bytes(key, path, strlen(path));
+
+	/* The quoted arguments of the preprocessor command are mostly
+	   temporary files with a different name for each compile, so
+	   use their contents instead of their names. */
+      const char*cp = ivlpp_string;
+      while (const char*qp = strchr(cp, '"')) {
+	    const char*ep = strchr(qp+1, '"');
+	    if (ep == 0)
+		  break;
+
+	    hash_bytes(key, cp, qp-cp);
+	    string arg (qp+1, ep-qp-1);
+	    if (! hash_file(key, arg.c_str()))
+		  hash_bytes(key, arg.c_str(), arg.size());
+	    cp = ep + 1;
+      }
+      hash_bytes(key, cp, strlen(cp));
+
+      return hash_file(key, path);
+}
+
+static string library_cache_path(uint64_t key, const char*suffix)
+{
+      char buf[64];
+      snprintf(buf, sizeof buf, "%c%016" PRIx64 "%s", dir_character,
+	       key, suffix);
+      return string(library_cache_dir) + buf;
+}
+
+/*
+ * Return the preprocessed text of the library file if the cache has a
+ * valid entry for it, or nil.
+ */
+static FILE* library_cache_lookup(uint64_t key)
+{
+      FILE*dep = fopen(library_cache_path(key, ".d").c_str(), "r");
+      if (dep == 0)
+	    return 0;
+
+      bool valid = true;
+      char line[4096];
+      while (valid && fgets(line, sizeof line, dep)) {
+	    char*ep = line + strlen(line);
+	    while (ep > line && (ep[-1] == '\n' || ep[-1] == '\r'))
+		  *--ep = 0;
+
+	    char*np = strchr(line, ' ');
+	    if (np == 0) {
+		  valid = false;
+		  break;
+	    }
+	    *np++ = 0;
+
+	    uint64_t hash = FNV_OFFSET;
+	    if (! hash_file(hash, np) || strtoull(line, 0, 16) != hash)
+		  valid = false;
+      }
+      fclose(dep);
+
+      if (! valid)
+	    return 0;
+
+      return fopen(library_cache_path(key, ".v").c_str(), "r");
+}
+
+/*
+ * Make a file that contains the given text, positioned at the start
+ * of the text and ready to be parsed.
+ */
+static FILE* text_to_file(const string&text)
+{
+      FILE*file = tmpfile();
+      if (file == 0)
+	    return 0;
+
+      fwrite(text.data(), 1, text.size(), file);
+      rewind(file);
+      return file;
+}
+
+/*
+ * Store the preprocessed text of a library file in the cache. Return
+ * a file that contains the text, ready to be parsed.
+ */
+static FILE* library_cache_store(uint64_t key, const string&text)
+{
+	/* The preprocessor marks every file that it enters with a
+	   `line directive, so these give the list of included files. */
+      set<string> deps;
+      for (size_t pos = text.find("`line ") ; pos != string::npos
+		 ; pos = text.find("`line ", pos+1)) {
+	    size_t qp = text.find('"', pos);
+	    if (qp == string::npos)
+		  break;
+	    size_t ep = text.find_first_of("\"\n", qp+1);
+	    if (ep == string::npos || text[ep] != '"')
+		  continue;
+	    deps.insert(text.substr(qp+1, ep-qp-1));
+      }
+
+      string vpath = library_cache_path(key, ".v");
+      string dpath = library_cache_path(key, ".d");
+      string vtmp = vpath + ".tmp";
+      string dtmp = dpath + ".tmp";
+
+      bool ok = true;
+      if (FILE*out = fopen(vtmp.c_str(), "wb")) {
+	    ok = fwrite(text.data(), 1, text.size(), out) == text.size();
+	    ok = (fclose(out) == 0) && ok;
+      } else {
+	    ok = false;
+      }
+
+      if (FILE*out = ok? fopen(dtmp.c_str(), "w") : 0) {
+	    for (set<string>::const_iterator cur = deps.begin()
+		       ; cur != deps.end() ; ++ cur ) {
+		  uint64_t hash = FNV_OFFSET;
+		  if (! hash_file(hash, cur->c_str())) {
+			ok = false;
+			break;
+		  }
+		  fprintf(out, "%016" PRIx64 " %s\n", hash, cur->c_str());
+	    }
+	    ok = (fclose(out) == 0) && ok;
+      } else {
+	    ok = false;
+      }
+
+	/* Install the text before the dependency list, since it is
+	   the dependency list that makes the entry valid. */
+      if (ok)
+	    ok = rename(vtmp.c_str(), vpath.c_str()) == 0
+	      && rename(dtmp.c_str(), dpath.c_str()) == 0;
+
+      if (! ok) {
+	    remove(vtmp.c_str());
+	    remove(dtmp.c_str());
+	    if (verbose_flag)
+		  cerr << "Unable to write library cache entry "
+		       << vpath << "." << endl;
+      }
+
+      return text_to_file(text);
+}
+
 /*
  * Use the type name as a key, and search the module library for a
  * file name that has that key.
@@ -82,7 +269,21 @@ bool load_module(const char*type)
 		  fflush(depend_file);
 	    }
 
-	    if (ivlpp_string) {
+	    uint64_t cache_key = 0;
+	    bool use_cache = ivlpp_string && library_cache_dir
+		  && library_cache_key(path, cache_key);
+
+	    FILE*cached = use_cache? library_cache_lookup(cache_key) : 0;
+
+	    if (cached) {
+		  if (verbose_flag)
+			cerr << "Loading library file " << path
+			     << " from cache." << endl;
+
+		  pform_parse(path, cached);
+		  fclose(cached);
+
+	    } else if (ivlpp_string) {
 		  char*cmdline = (char*)malloc(strlen(ivlpp_string) +
 					       strlen(path) + 4);
 		  strcpy(cmdline, ivlpp_string);
@@ -98,8 +299,26 @@ bool load_module(const char*type)
 		  if (verbose_flag)
 			cerr << "...parsing output from preprocessor..." << endl << flush;
 
-		  pform_parse(path, file);
-		  pclose(file);
+		  if (use_cache) {
+			  /* Collect all the preprocessor output, and
+			     only keep it if the preprocessor worked. */
+			string text;
+			char buf[16*1024];
+			size_t cnt;
+			while ((cnt = fread(buf, 1, sizeof buf, file)) > 0)
+			      text.append(buf, cnt);
+
+			if (pclose(file) == 0)
+			      file = library_cache_store(cache_key, text);
+			else
+			      file = text_to_file(text);
+			assert(file);
+			pform_parse(path, file);
+			fclose(file);
+		  } else {
+			pform_parse(path, file);
+			pclose(file);
+		  }
 		  free(cmdline);
 
 	    } else {
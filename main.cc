@@ -50,6 +50,11 @@ const char NOTICE[] =
 #if defined(HAVE_TIMES)
 # include  <sys/times.h>
 #endif
+#if defined(HAVE_SYS_RESOURCE_H)
+# include  <sys/time.h>
+# include  <sys/resource.h>
+#endif
+# include  <ctime>
 #if defined(HAVE_GETOPT_H)
 # include  <getopt.h>
 #endif
@@ -144,6 +149,8 @@ list<perm_string> roots;
 
 char*ivlpp_string = 0;
 
+const char*library_cache_dir = 0;
+
 char depfile_mode = 'a';
 char* depfile_name = NULL;
 FILE *depend_file = NULL;
@@ -757,6 +764,191 @@ inline static void times(struct tms *) { }
 inline static double cycles_diff(struct tms *, struct tms *) { return 0; }
 #endif // ! defined(HAVE_TIMES)
 
+/*
+ * The compiler keeps a record of the time and memory used by each
+ * phase of the compile, including each functor. If the PROFILE_REPORT
+ * flag names a file, then this record, along with counts of the
+ * objects that the phases create, is written to that file as a JSON
+ * object.
+ */
+struct profile_sample_t {
+      double wall, user, sys;
+	// Peak resident size, in the units of ru_maxrss (KBytes on Linux).
+      long peak_rss;
+};
+
+struct profile_phase_t {
+      string name;
+      profile_sample_t start, end;
+	// Netlist objects that exist at the end of the phase.
+      unsigned long nexus, links;
+};
+
+static list<profile_phase_t> profile_phases;
+static profile_sample_t profile_mark;
+
+struct pform_stats_t {
+      pform_stats_t() : wires(0), gates(0), behaviors(0), generates(0),
+			tasks(0), funcs(0) { }
+      unsigned long wires, gates, behaviors, generates, tasks, funcs;
+};
+
+static map<perm_string,pform_stats_t> profile_pform;
+static design_stats_t profile_elaborated, profile_final;
+
+static void profile_sample(profile_sample_t&sample)
+{
+#if defined(HAVE_SYS_RESOURCE_H)
+      struct timeval tv;
+      gettimeofday(&tv, 0);
+      sample.wall = tv.tv_sec + tv.tv_usec/1E6;
+
+      struct rusage ru;
+      getrusage(RUSAGE_SELF, &ru);
+      sample.user = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec/1E6;
+      sample.sys  = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec/1E6;
+      sample.peak_rss = ru.ru_maxrss;
+#else
+      sample.wall = time(0);
+      sample.user = clock() / (double)CLOCKS_PER_SEC;
+      sample.sys  = 0.0;
+      sample.peak_rss = 0;
+#endif
+}
+
+/*
+ * Close the current phase, and start the next phase from here.
+ */
+static const profile_phase_t& profile_phase_done(const string&name)
+{
+      profile_phase_t tmp;
+      tmp.name = name;
+      tmp.start = profile_mark;
+      profile_sample(tmp.end);
+      tmp.nexus = Nexus::live_count();
+      tmp.links = NetPins::live_links();
+      profile_phases.push_back(tmp);
+
+      profile_mark = tmp.end;
+      return profile_phases.back();
+}
+
+static void profile_collect_pform(void)
+{
+      for (map<perm_string,Module*>::const_iterator mod = pform_modules.begin()
+		 ; mod != pform_modules.end() ; ++ mod ) {
+	    pform_stats_t&cur = profile_pform[mod->first];
+	    cur.wires = mod->second->wires.size();
+	    cur.gates = mod->second->get_gates().size();
+	    cur.behaviors = mod->second->behaviors.size()
+		  + mod->second->analog_behaviors.size();
+	    cur.generates = mod->second->generate_schemes.size();
+	    cur.tasks = mod->second->tasks.size();
+	    cur.funcs = mod->second->funcs.size();
+      }
+}
+
+static void json_string(ostream&out, const char*str)
+{
+      out << '"';
+      for ( ; *str ; str += 1) switch (*str) {
+	  case '"':
+	    out << "\\\"";
+	    break;
+	  case '\\':
+	    out << "\\\\";
+	    break;
+	  default:
+	    if ((unsigned char)*str < 0x20) {
+		  char buf[8];
+		  snprintf(buf, sizeof buf, "\\u%04x", *str);
+		  out << buf;
+	    } else {
+		  out << *str;
+	    }
+	    break;
+      }
+      out << '"';
+}
+
+static void json_counts(ostream&out, const design_stats_t::counts_t&cnt)
+{
+      out << "\"instances\": " << cnt.instances
+	  << ", \"scopes\": " << cnt.scopes
+	  << ", \"signals\": " << cnt.signals
+	  << ", \"nodes\": " << cnt.nodes
+	  << ", \"processes\": " << cnt.processes
+	  << ", \"pins\": " << cnt.pins;
+}
+
+static void json_design_stats(ostream&out, const design_stats_t&stats)
+{
+      out << "{ ";
+      json_counts(out, stats.total);
+      out << "," << endl << "      \"modules\": [";
+      const char*sep = "";
+      for (map<perm_string,design_stats_t::counts_t>::const_iterator cur = stats.modules.begin()
+		 ; cur != stats.modules.end() ; ++ cur ) {
+	    out << sep << endl << "        { \"name\": ";
+	    json_string(out, cur->first.str());
+	    out << ", ";
+	    json_counts(out, cur->second);
+	    out << " }";
+	    sep = ",";
+      }
+      out << " ] }";
+}
+
+static void write_profile_report(const char*path)
+{
+      ofstream out (path);
+      if (! out.is_open()) {
+	    cerr << "error: Unable to write profile report " << path << endl;
+	    return;
+      }
+
+      out << "{" << endl << "  \"phases\": [";
+      const char*sep = "";
+      for (list<profile_phase_t>::const_iterator cur = profile_phases.begin()
+		 ; cur != profile_phases.end() ; ++ cur ) {
+	    out << sep << endl << "    { \"name\": ";
+	    json_string(out, cur->name.c_str());
+	    out << ", \"wall\": " << cur->end.wall - cur->start.wall
+		<< ", \"user\": " << cur->end.user - cur->start.user
+		<< ", \"sys\": " << cur->end.sys - cur->start.sys
+		<< ", \"peak_rss\": " << cur->end.peak_rss
+		<< ", \"nexus\": " << cur->nexus
+		<< ", \"links\": " << cur->links << " }";
+	    sep = ",";
+      }
+      out << " ]," << endl;
+
+      out << "  \"peak_nexus\": " << Nexus::peak_count() << "," << endl;
+      out << "  \"peak_links\": " << NetPins::peak_links() << "," << endl;
+
+      out << "  \"pform\": [";
+      sep = "";
+      for (map<perm_string,pform_stats_t>::const_iterator cur = profile_pform.begin()
+		 ; cur != profile_pform.end() ; ++ cur ) {
+	    out << sep << endl << "    { \"name\": ";
+	    json_string(out, cur->first.str());
+	    out << ", \"wires\": " << cur->second.wires
+		<< ", \"gates\": " << cur->second.gates
+		<< ", \"behaviors\": " << cur->second.behaviors
+		<< ", \"generates\": " << cur->second.generates
+		<< ", \"tasks\": " << cur->second.tasks
+		<< ", \"functions\": " << cur->second.funcs << " }";
+	    sep = ",";
+      }
+      out << " ]," << endl;
+
+      out << "  \"elaborated\": ";
+      json_design_stats(out, profile_elaborated);
+      out << "," << endl << "  \"final\": ";
+      json_design_stats(out, profile_final);
+      out << endl << "}" << endl;
+}
+
 static void EOC_cleanup(void)
 {
       cleanup_sys_func_table();
@@ -988,6 +1180,14 @@ int main(int argc, char*argv[])
       flag_tmp = flags["DISABLE_CONCATZ_GENERATION"];
       if (flag_tmp) disable_concatz_generation = strcmp(flag_tmp,"true")==0;
 
+      flag_tmp = flags["LIBRARY_CACHE_DIR"];
+      if (flag_tmp && *flag_tmp) library_cache_dir = flag_tmp;
+
+      const char*profile_report = flags["PROFILE_REPORT"];
+      if (profile_report && *profile_report == 0) profile_report = 0;
+
+      profile_sample(profile_mark);
+
 	/* Parse the input. Make the pform. */
       pform_set_timescale(def_ts_units, def_ts_prec, 0, 0);
       int rc = pform_parse(argv[optind]);
@@ -1022,7 +1222,13 @@ int main(int argc, char*argv[])
 	    }
       }
 
+      profile_phase_done("parse");
+      if (profile_report)
+	    profile_collect_pform();
+
       if (rc) {
+	    if (profile_report)
+		  write_profile_report(profile_report);
 	    return rc;
       }
 
@@ -1088,6 +1294,10 @@ int main(int argc, char*argv[])
 	/* On with the process of elaborating the module. */
       Design*des = elaborate(roots);
 
+      profile_phase_done("elaborate");
+      if (profile_report && des)
+	    des->collect_stats(profile_elaborated);
+
       if ((des == 0) || (des->errors > 0)) {
 	    if (des != 0) {
 		  cerr << des->errors
@@ -1100,6 +1310,8 @@ int main(int argc, char*argv[])
 		  cerr << "Elaboration failed" << endl;
 	    }
 
+	    if (profile_report)
+		  write_profile_report(profile_report);
 	    goto errors_summary;
       }
 
@@ -1142,12 +1354,23 @@ int main(int argc, char*argv[])
 	    if (verbose_flag)
 		  cerr<<" -F "<<net_func_to_name(func)<< " ..." <<endl;
 	    func(des);
+
+	    const profile_phase_t&phase
+		  = profile_phase_done(string("functor:") + net_func_to_name(func));
+	    if (verbose_flag && times_flag)
+		  cerr<<" ... done, "
+		      <<(phase.end.user + phase.end.sys
+			 - phase.start.user - phase.start.sys)
+		      <<" seconds."<<endl;
       }
 
       if (verbose_flag) {
 	    cout << "CALCULATING ISLANDS" << endl;
       }
       des->join_islands();
+      profile_phase_done("islands");
+      if (profile_report)
+	    des->collect_stats(profile_final);
 
       if (net_path) {
 	    if (verbose_flag)
@@ -1161,6 +1384,8 @@ int main(int argc, char*argv[])
 	    cerr << des->errors
 		 << " error(s) in post-elaboration processing." <<
 		  endl;
+	    if (profile_report)
+		  write_profile_report(profile_report);
 	    return des->errors;
       }
 
@@ -1176,7 +1401,13 @@ int main(int argc, char*argv[])
 	    cout << "CODE GENERATION" << endl;
       }
 
-      if (int emit_rc = des->emit(&dll_target_obj)) {
+      int emit_rc;
+      emit_rc = des->emit(&dll_target_obj);
+      profile_phase_done("emit");
+      if (profile_report)
+	    write_profile_report(profile_report);
+
+      if (emit_rc) {
 	    if (emit_rc > 0) {
 		  cerr << "error: Code generation had "
 		       << emit_rc << " error(s)."
@@ -911,3 +911,89 @@ void Design::join_islands(void)
 	    cur = cur->node_next_;
       } while (cur != nodes_->node_next_);
 }
+
+/*
+ * The module that a scope belongs to is the module instance that
+ * most closely contains it. Scopes in packages have no module.
+ */
+static design_stats_t::counts_t* module_counts(design_stats_t&stats,
+					      const NetScope*scope)
+{
+      while (scope && scope->type() != NetScope::MODULE)
+	    scope = scope->parent();
+
+      if (scope == 0)
+	    return 0;
+
+      return &stats.modules[scope->module_name()];
+}
+
+void NetScope::collect_stats(design_stats_t&stats) const
+{
+      design_stats_t::counts_t*mod = module_counts(stats, this);
+
+      stats.total.scopes += 1;
+      stats.total.signals += signals_map_.size();
+      if (type_ == MODULE)
+	    stats.total.instances += 1;
+
+      if (mod) {
+	    mod->scopes += 1;
+	    mod->signals += signals_map_.size();
+	    if (type_ == MODULE)
+		  mod->instances += 1;
+      }
+
+      for (signals_map_iter_t cur = signals_map_.begin()
+		 ; cur != signals_map_.end() ; ++ cur ) {
+	    stats.total.pins += cur->second->pin_count();
+	    if (mod) mod->pins += cur->second->pin_count();
+      }
+
+      for (map<hname_t,NetScope*>::const_iterator cur = children_.begin()
+		 ; cur != children_.end() ; ++ cur )
+	    cur->second->collect_stats(stats);
+}
+
+/*
+ * Nodes and processes are kept by the Design, so it adds their counts
+ * to the scope that each belongs to.
+ */
+static void stats_add_node(design_stats_t&stats, const NetNode*node)
+{
+      stats.total.nodes += 1;
+      stats.total.pins += node->pin_count();
+      if (design_stats_t::counts_t*mod = module_counts(stats, node->scope())) {
+	    mod->nodes += 1;
+	    mod->pins += node->pin_count();
+      }
+}
+
+static void stats_add_process(design_stats_t&stats, const NetProcTop*proc)
+{
+      stats.total.processes += 1;
+      if (design_stats_t::counts_t*mod = module_counts(stats, proc->scope()))
+	    mod->processes += 1;
+}
+
+void Design::collect_stats(design_stats_t&stats) const
+{
+      for (map<perm_string,NetScope*>::const_iterator cur = packages_.begin()
+		 ; cur != packages_.end() ; ++ cur )
+	    cur->second->collect_stats(stats);
+
+      for (list<NetScope*>::const_iterator scope = root_scopes_.begin()
+		 ; scope != root_scopes_.end() ; ++ scope )
+	    (*scope)->collect_stats(stats);
+
+      if (nodes_) {
+	    const NetNode*cur = nodes_;
+	    do {
+		  stats_add_node(stats, cur);
+		  cur = cur->node_next_;
+	    } while (cur != nodes_);
+      }
+
+      for (const NetProcTop*cur = procs_ ;  cur ;  cur = cur->next_)
+	    stats_add_process(stats, cur);
+}
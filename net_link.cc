@@ -236,8 +236,15 @@ bool Link::is_linked(const Link&that) const
       return false;
 }
 
+unsigned long Nexus::live_count_ = 0;
+unsigned long Nexus::peak_count_ = 0;
+
 Nexus::Nexus(Link&that)
 {
+      live_count_ += 1;
+      if (live_count_ > peak_count_)
+	    peak_count_ = live_count_;
+
       name_ = 0;
       driven_ = NO_GUESS;
       t_cookie_ = 0;
@@ -263,6 +270,7 @@ Nexus::Nexus(Link&that)
 
 Nexus::~Nexus()
 {
+      live_count_ -= 1;
       assert(list_ == 0);
       delete[] name_;
 }
@@ -539,18 +547,9 @@ void NexusSet::add(Nexus*that, unsigned base, unsigned wid)
       assert(that);
       elem_t cur (that, base, wid);
 
-      if (items_.size() == 0) {
-	    items_.resize(1);
-	    items_[0] = cur;
-	    return;
-      }
-
-      unsigned ptr = bsearch_(cur);
-      if (ptr < items_.size()) {
+      unsigned ptr = items_.size();
+      if (! index_.insert(std::make_pair(cur, ptr)).second)
 	    return;
-      }
-
-      assert(ptr == items_.size());
 
       items_.push_back(cur);
 }
@@ -561,30 +560,41 @@ void NexusSet::add(const NexusSet&that)
 	    add(that.items_[idx].nex, that.items_[idx].base, that.items_[idx].wid);
 }
 
-void NexusSet::rem_(const NexusSet::elem_t&that)
+/*
+ * Remove all the items of that set in one pass. The remaining items
+ * keep their order, so they are renumbered in the index as the list
+ * is compacted.
+ */
+void NexusSet::rem(const NexusSet&that)
 {
       if (items_.empty())
 	    return;
 
-      unsigned ptr = bsearch_(that);
-      if (ptr >= items_.size())
-	    return;
-
-      if (items_.size() == 1) {
-	    items_.clear();
-	    return;
+      std::vector<bool> dead (items_.size(), false);
+      bool any = false;
+      for (size_t idx = 0 ;  idx < that.items_.size() ;  idx += 1) {
+	    std::map<elem_t,unsigned>::iterator cur = index_.find(that.items_[idx]);
+	    if (cur == index_.end())
+		  continue;
+	    dead[cur->second] = true;
+	    index_.erase(cur);
+	    any = true;
       }
 
-      for (unsigned idx = ptr ;  idx < (items_.size()-1) ;  idx += 1)
-	    items_[idx] = items_[idx+1];
-
-      items_.pop_back();
-}
+      if (! any)
+	    return;
 
-void NexusSet::rem(const NexusSet&that)
-{
-      for (size_t idx = 0 ;  idx < that.items_.size() ;  idx += 1)
-	    rem_(that.items_[idx]);
+      unsigned ptr = 0;
+      for (unsigned idx = 0 ;  idx < items_.size() ;  idx += 1) {
+	    if (dead[idx])
+		  continue;
+	    if (ptr != idx) {
+		  items_[ptr] = items_[idx];
+		  index_[items_[ptr]] = ptr;
+	    }
+	    ptr += 1;
+      }
+      items_.resize(ptr);
 }
 
 unsigned NexusSet::find_nexus(const NexusSet::elem_t&that) const
@@ -600,12 +610,11 @@ const NexusSet::elem_t& NexusSet::at (unsigned idx) const
 
 size_t NexusSet::bsearch_(const NexusSet::elem_t&that) const
 {
-      for (unsigned idx = 0 ;  idx < items_.size() ;  idx += 1) {
-	    if (items_[idx]==that)
-		  return idx;
-      }
+      std::map<elem_t,unsigned>::const_iterator cur = index_.find(that);
+      if (cur == index_.end())
+	    return items_.size();
 
-      return items_.size();
+      return cur->second;
 }
 
 bool NexusSet::elem_t::contains(const struct elem_t&that) const
@@ -620,10 +629,19 @@ bool NexusSet::elem_t::contains(const struct elem_t&that) const
       return true;
 }
 
+/*
+ * The index is sorted by nexus and then by base, so the only items
+ * that can contain that item are the ones for the same nexus with a
+ * base at or below the base of that item.
+ */
 bool NexusSet::contains_(const NexusSet::elem_t&that) const
 {
-      for (unsigned idx = 0 ; idx < items_.size() ; idx += 1) {
-	    if (items_[idx].contains(that))
+      std::map<elem_t,unsigned>::const_iterator cur
+	    = index_.lower_bound(elem_t(that.nex, 0, 0));
+      for ( ; cur != index_.end() ; ++ cur) {
+	    if (cur->first.nex != that.nex || cur->first.base > that.base)
+		  break;
+	    if (cur->first.contains(that))
 		  return true;
       }
       return false;
@@ -641,6 +659,10 @@ bool NexusSet::contains(const NexusSet&that) const
 
 bool NexusSet::intersect(const NexusSet&that) const
 {
+	// Scan the smaller set and look up its items in the larger.
+      if (that.items_.size() > items_.size())
+	    return that.intersect(*this);
+
       for (size_t idx = 0 ;  idx < that.items_.size() ;  idx += 1) {
 	    size_t where = bsearch_(that.items_[idx]);
 	    if (where == items_.size())
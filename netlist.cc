@@ -155,6 +155,9 @@ void NetPins::devirtualize_pins(void)
       if (debug_optimizer && npins_ > 1000) cerr << "debug: devirtualizing " << npins_ << " pins." << endl;
 
       pins_ = new Link[npins_];
+      live_links_ += npins_;
+      if (live_links_ > peak_links_)
+	    peak_links_ = live_links_;
       pins_[0].pin_zero_ = true;
       pins_[0].node_ = this;
       pins_[0].dir_  = default_dir_;
@@ -171,6 +174,9 @@ bool NetPins::pins_are_virtual(void) const
       return pins_ == NULL;
 }
 
+unsigned long NetPins::live_links_ = 0;
+unsigned long NetPins::peak_links_ = 0;
+
 NetPins::NetPins(unsigned npins)
 : npins_(npins)
 {
@@ -180,6 +186,7 @@ NetPins::NetPins(unsigned npins)
 
 NetPins::~NetPins()
 {
+      if (pins_) live_links_ -= npins_;
       delete[] pins_;
 }
 
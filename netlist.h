@@ -85,6 +85,7 @@ class netvector_t;
 
 struct target;
 struct functor_t;
+struct design_stats_t;
 
 ostream& operator << (ostream&o, ivl_variable_type_t val);
 
@@ -203,7 +204,14 @@ class NetPins : public LineInfo {
       bool pins_are_virtual(void) const;
       void devirtualize_pins(void);
 
+	/* These count the Link objects that exist now, and the most
+	   that existed at any one time. They are for profiling. */
+      static unsigned long live_links() { return live_links_; }
+      static unsigned long peak_links() { return peak_links_; }
+
     private:
+      static unsigned long live_links_, peak_links_;
+
       Link*pins_;
       const unsigned npins_;
       Link::DIR default_dir_;
@@ -386,7 +394,14 @@ class Nexus {
       ivl_nexus_t t_cookie() const { return t_cookie_; }
       void t_cookie(ivl_nexus_t) const;
 
+	/* These count the Nexus objects that exist now, and the most
+	   that existed at any one time. They are for profiling. */
+      static unsigned long live_count() { return live_count_; }
+      static unsigned long peak_count() { return peak_count_; }
+
     private:
+      static unsigned long live_count_, peak_count_;
+
       Link*list_;
       void unlink(Link*);
 
@@ -413,6 +428,11 @@ class NexusSet {
 	    inline elem_t() : nex(0), base(0), wid(0) { }
 	    inline bool operator == (const struct elem_t&that) const
 	    { return nex==that.nex && base==that.base && wid==that.wid; }
+	    inline bool operator < (const struct elem_t&that) const
+	    { if (nex != that.nex) return nex < that.nex;
+	      if (base != that.base) return base < that.base;
+	      return wid < that.wid;
+	    }
 
 	    bool contains(const struct elem_t&that) const;
 
@@ -448,11 +468,14 @@ class NexusSet {
       bool intersect(const NexusSet&that) const;
 
     private:
-	// NexSet items are canonical part selects of vectors.
+	// NexSet items are canonical part selects of vectors. They
+	// are kept in the order they were added, and the index_ maps
+	// each item to its position so that lookups need not scan
+	// the list.
       std::vector<struct elem_t> items_;
+      std::map<struct elem_t,unsigned> index_;
 
       size_t bsearch_(const struct elem_t&that) const;
-      void rem_(const struct elem_t&that);
       bool contains_(const elem_t&htat) const;
 
     private: // not implemented
@@ -1037,6 +1060,8 @@ class NetScope : public Attrib {
       perm_string local_symbol();
 
       void dump(ostream&) const;
+	/* Add the counts for this scope and its children. */
+      void collect_stats(design_stats_t&) const;
       void emit_scope(struct target_t*tgt) const;
       bool emit_defs(struct target_t*tgt) const;
 
@@ -4429,6 +4454,23 @@ struct elaborator_work_item_t {
       Design*des;
 };
 
+/*
+ * Counts of the objects in an elaborated design, for profiling the
+ * compiler. The per-module counts are keyed by module definition
+ * name, and add up all the instances of that module. Objects in a
+ * nested instance are counted against the inner module only.
+ */
+struct design_stats_t {
+      struct counts_t {
+	    counts_t() : instances(0), scopes(0), signals(0), nodes(0),
+			 processes(0), pins(0) { }
+	    unsigned long instances, scopes, signals, nodes, processes, pins;
+      };
+
+      counts_t total;
+      map<perm_string,counts_t> modules;
+};
+
 /*
  * This class contains an entire design. It includes processes and a
  * netlist, and can be passed around from function to function.
@@ -4539,6 +4581,7 @@ class Design {
 
 	// Iterate over the design...
       void dump(ostream&) const;
+      void collect_stats(design_stats_t&) const;
       void functor(struct functor_t*);
       void join_islands(void);
       int emit(struct target_t*) const;
@@ -210,6 +210,10 @@ void nodangle(Design*des)
 
             fun.scontinue = false;
             fun.econtinue = false;
+	      // Only scan the kinds of objects that are not complete.
+	    fun.scan_mask = 0;
+	    if (! fun.scomplete) fun.scan_mask |= functor_t::SCAN_SIGNALS;
+	    if (! fun.ecomplete) fun.scan_mask |= functor_t::SCAN_EVENTS;
 	    des->functor(&fun);
 	    fun.iteration += 1;
             fun.scomplete = !fun.scontinue;
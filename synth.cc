@@ -113,7 +113,7 @@ int do_expr::event_wait(NetEvWait*stmt)
 class synth_f  : public functor_t {
 
     public:
-      synth_f() { top_ = NULL; }
+      synth_f() { top_ = NULL; scan_mask = SCAN_PROCESSES; }
       void process(Design*, NetProcTop*);
 
     private:
@@ -888,6 +888,7 @@ bool NetProcTop::synth_sync(Design*des)
 class synth2_f  : public functor_t {
 
     public:
+      synth2_f() { scan_mask = SCAN_PROCESSES; }
       void process(Design*, NetProcTop*);
 
     private:
@@ -47,6 +47,18 @@ static int eval_darray_new(ivl_expr_t ex)
 	    assert(ivl_type_packed_dimensions(element_type) == 0);
 	    fprintf(vvp_out, "    %%new/darray %u, \"S\";\n", size_reg);
 	    break;
+	  case IVL_VT_LOGIC: {
+		// 4-state words are kept packed by the runtime. Multiple
+		// packed dimensions are flattened into a single width.
+		unsigned idx, wid = 1;
+		for (idx = 0 ; idx < ivl_type_packed_dimensions(element_type) ; idx += 1) {
+		      int msb = ivl_type_packed_msb(element_type, idx);
+		      int lsb = ivl_type_packed_lsb(element_type, idx);
+		      wid *= (msb>=lsb? msb - lsb : lsb - msb) + 1;
+		}
+		fprintf(vvp_out, "    %%new/darray %u, \"v%u\";\n", size_reg, wid);
+		break;
+	  }
 	  case IVL_VT_BOOL:
 	      // bool objects are vectorable, but for now only support
 	      // a single dimensions.
@@ -46,6 +46,13 @@ static const char*version_string =
 
 FILE*vvp_out = 0;
 int vvp_errors = 0;
+
+/*
+ * The generated code is written with a great many small fprintf
+ * calls, so give the output file a large buffer to keep the number
+ * of write system calls down for large designs.
+ */
+static char vvp_out_buffer[256*1024];
 unsigned show_file_line = 0;
 
 __inline__ static void draw_execute_header(ivl_design_t des)
@@ -137,6 +144,7 @@ int target_design(ivl_design_t des)
 	    perror(path);
 	    return -1;
       }
+      setvbuf(vvp_out, vvp_out_buffer, _IOFBF, sizeof(vvp_out_buffer));
 
       vvp_errors = 0;
 
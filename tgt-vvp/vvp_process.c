@@ -2321,6 +2321,94 @@ static int show_statement(ivl_statement_t net, ivl_scope_t sscope)
  * code to terminate the thread.
  */
 
+/*
+ * Recognize the free running clock idiom
+ *
+ *     always #N clk = ~clk;
+ *
+ * where clk is a whole, non-array variable and N is a constant delay
+ * greater than zero. Such a process is written as a .clock statement
+ * so that the run time can toggle the variable with a single
+ * self-scheduling event instead of running a thread every half
+ * period. Return true if the process was drawn this way.
+ */
+static int draw_clock_process(ivl_process_t net, ivl_scope_t scope)
+{
+      ivl_statement_t stmt = ivl_process_stmt(net);
+      ivl_statement_t asgn;
+      ivl_lval_t lval;
+      ivl_signal_t sig;
+      ivl_expr_t rval, oper;
+      uint64_t delay;
+
+      if (ivl_process_type(net) != IVL_PR_ALWAYS)
+	    return 0;
+      if (ivl_scope_is_auto(scope))
+	    return 0;
+
+	/* Allow for a begin/end around the statement. */
+      while (ivl_statement_type(stmt) == IVL_ST_BLOCK
+	     && ivl_stmt_block_scope(stmt) == 0
+	     && ivl_stmt_block_count(stmt) == 1)
+	    stmt = ivl_stmt_block_stmt(stmt, 0);
+
+      if (ivl_statement_type(stmt) != IVL_ST_DELAY)
+	    return 0;
+      delay = ivl_stmt_delay_val(stmt);
+      if (delay == 0)
+	    return 0;
+
+      asgn = ivl_stmt_sub_stmt(stmt);
+      if (ivl_statement_type(asgn) != IVL_ST_ASSIGN)
+	    return 0;
+      if (ivl_stmt_lvals(asgn) != 1)
+	    return 0;
+      if (ivl_stmt_opcode(asgn) != 0)
+	    return 0;
+      if (ivl_stmt_delay_expr(asgn) != 0)
+	    return 0;
+
+      lval = ivl_stmt_lval(asgn, 0);
+      sig = ivl_lval_sig(lval);
+      if (sig == 0)
+	    return 0;
+      if (ivl_lval_idx(lval) || ivl_lval_part_off(lval) || ivl_lval_mux(lval))
+	    return 0;
+      if (ivl_signal_type(sig) != IVL_SIT_REG)
+	    return 0;
+      if (ivl_signal_dimensions(sig) != 0)
+	    return 0;
+      switch (ivl_signal_data_type(sig)) {
+	  case IVL_VT_LOGIC:
+	  case IVL_VT_BOOL:
+	    break;
+	  default:
+	    return 0;
+      }
+      if (ivl_lval_width(lval) != ivl_signal_width(sig))
+	    return 0;
+
+      rval = ivl_stmt_rval(asgn);
+      if (ivl_expr_type(rval) != IVL_EX_UNARY || ivl_expr_opcode(rval) != '~')
+	    return 0;
+      if (ivl_expr_width(rval) != ivl_signal_width(sig))
+	    return 0;
+
+      oper = ivl_expr_oper1(rval);
+      if (ivl_expr_type(oper) != IVL_EX_SIGNAL || ivl_expr_signal(oper) != sig)
+	    return 0;
+      if (ivl_expr_oper1(oper) != 0)
+	    return 0;
+      if (ivl_expr_width(oper) != ivl_signal_width(sig))
+	    return 0;
+
+      fprintf(vvp_out, "    .scope S_%p;\n", scope);
+      fprintf(vvp_out, "    .clock v%p_0, %lu, %lu;\n", sig,
+	      (unsigned long)(delay % UINT64_C(0x100000000)),
+	      (unsigned long)(delay / UINT64_C(0x100000000)));
+      return 1;
+}
+
 int draw_process(ivl_process_t net, void*x)
 {
       int rc = 0;
@@ -2345,6 +2433,10 @@ int draw_process(ivl_process_t net, void*x)
 	    }
       }
 
+	/* A free running clock does not need a thread at all. */
+      if (!push_flag && draw_clock_process(net, scope))
+	    return rc;
+
       local_count = 0;
       fprintf(vvp_out, "    .scope S_%p;\n", scope);
 
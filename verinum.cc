@@ -24,6 +24,7 @@
 # include  <cassert>
 # include  <cmath> // Needed to get pow for as_double().
 # include  <cstdio> // Needed to get snprintf for as_string().
+# include  <vector>
 
 #if !defined(HAVE_LROUND)
 /*
@@ -43,17 +44,16 @@ extern "C" long int lround(double x)
 static verinum::V add_with_carry(verinum::V l, verinum::V r, verinum::V&c);
 
 verinum::verinum()
-: bits_(0), nbits_(0), has_len_(false), has_sign_(false), is_single_(false), string_flag_(false)
+: abits_(0), bbits_(0), nbits_(0), has_len_(false), has_sign_(false), is_single_(false), string_flag_(false)
 {
 }
 
 verinum::verinum(const V*bits, unsigned nbits, bool has_len__)
 : has_len_(has_len__), has_sign_(false), is_single_(false), string_flag_(false)
 {
-      nbits_ = nbits;
-      bits_ = new V [nbits];
+      alloc_(nbits);
       for (unsigned idx = 0 ;  idx < nbits ;  idx += 1) {
-	    bits_[idx] = bits[idx];
+	    if (bits[idx] != V0) set(idx, bits[idx]);
       }
 }
 
@@ -114,56 +114,37 @@ verinum::verinum(const string&s)
 : has_len_(true), has_sign_(false), is_single_(false), string_flag_(true)
 {
       string str = process_verilog_string_quotes(s);
-      nbits_ = str.length() * 8;
 
 	// Special case: The string "" is 8 bits of 0.
-      if (nbits_ == 0) {
-	    nbits_ = 8;
-	    bits_ = new V [nbits_];
-	    bits_[0] = V0;
-	    bits_[1] = V0;
-	    bits_[2] = V0;
-	    bits_[3] = V0;
-	    bits_[4] = V0;
-	    bits_[5] = V0;
-	    bits_[6] = V0;
-	    bits_[7] = V0;
+      if (str.length() == 0) {
+	    alloc_(8);
 	    return;
       }
 
-      bits_ = new V [nbits_];
+      alloc_(str.length() * 8);
 
+	// The first character is the most significant byte.
       unsigned idx, cp;
-      V*bp = bits_+nbits_;
       for (idx = nbits_, cp = 0 ;  idx > 0 ;  idx -= 8, cp += 1) {
-	    char ch = str[cp];
-	    *(--bp) = (ch&0x80) ? V1 : V0;
-	    *(--bp) = (ch&0x40) ? V1 : V0;
-	    *(--bp) = (ch&0x20) ? V1 : V0;
-	    *(--bp) = (ch&0x10) ? V1 : V0;
-	    *(--bp) = (ch&0x08) ? V1 : V0;
-	    *(--bp) = (ch&0x04) ? V1 : V0;
-	    *(--bp) = (ch&0x02) ? V1 : V0;
-	    *(--bp) = (ch&0x01) ? V1 : V0;
+	    unsigned long ch = (unsigned char)str[cp];
+	    unsigned base = idx - 8;
+	    abits_[base/BITS_PER_WORD] |= ch << (base%BITS_PER_WORD);
       }
 }
 
 verinum::verinum(verinum::V val, unsigned n, bool h)
 : has_len_(h), has_sign_(false), is_single_(false), string_flag_(false)
 {
-      nbits_ = n;
-      bits_ = new V[nbits_];
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    bits_[idx] = val;
+      alloc_(n);
+      fill_(0, val);
 }
 
 verinum::verinum(uint64_t val, unsigned n)
 : has_len_(true), has_sign_(false), is_single_(false), string_flag_(false)
 {
-      nbits_ = n;
-      bits_ = new V[nbits_];
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    bits_[idx] = (val&1) ? V1 : V0;
+      alloc_(n);
+      for (unsigned idx = 0 ;  idx < nbits_ && val != 0 ;  idx += 1) {
+	    if (val&1) set(idx, V1);
 	    val >>= (uint64_t)1;
       }
 }
@@ -180,9 +161,8 @@ verinum::verinum(double val, bool)
 
 	/* We return `bx for a NaN or +/- infinity. */
       if (val != val || (val && (val == 0.5*val))) {
-	    nbits_ = 1;
-	    bits_ = new V[nbits_];
-	    bits_[0] = Vx;
+	    alloc_(1);
+	    set(0, Vx);
 	    return;
       }
 
@@ -198,8 +178,7 @@ verinum::verinum(double val, bool)
 
 	/* Get the exponent and fractional part of the number. */
       fraction = frexp(val, &exponent);
-      nbits_ = exponent+1;
-      bits_ = new V[nbits_];
+      alloc_(exponent+1);
       const verinum const_one(1);
 
 	/* If the value is small enough just use lround(). */
@@ -207,7 +186,7 @@ verinum::verinum(double val, bool)
 	    long sval = lround(val);
 	    if (is_neg) sval = -sval;
 	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  bits_[idx] = (sval&1) ? V1 : V0;
+		  set(idx, (sval&1) ? V1 : V0);
 		  sval >>= 1;
 	    }
 	      /* Trim the result. */
@@ -223,7 +202,7 @@ verinum::verinum(double val, bool)
 	    unsigned long bits = (unsigned long) fraction;
 	    fraction = fraction - (double) bits;
 	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  bits_[idx] = (bits&1) ? V1 : V0;
+		  set(idx, (bits&1) ? V1 : V0);
 		  bits >>= 1;
 	    }
       } else {
@@ -233,7 +212,7 @@ verinum::verinum(double val, bool)
 		  unsigned max = (wd+1)*BITS_IN_LONG;
 		  if (max > nbits_) max = nbits_;
 		  for (unsigned idx = wd*BITS_IN_LONG; idx < max; idx += 1) {
-			bits_[idx] = (bits&1) ? V1 : V0;
+			set(idx, (bits&1) ? V1 : V0);
 			bits >>= 1;
 		  }
 		  fraction = ldexp(fraction, BITS_IN_LONG);
@@ -256,62 +235,52 @@ void verinum::signed_trim()
 {
 	/* Do we have any extra digits? */
       unsigned tlen = nbits_-1;
-      verinum::V sign = bits_[tlen];
-      while ((tlen > 0) && (bits_[tlen] == sign)) tlen -= 1;
+      verinum::V sign = get(tlen);
+      while ((tlen > 0) && (get(tlen) == sign)) tlen -= 1;
 
 	/* tlen now points to the first digit that is not the sign.
 	 * or bit 0. Set the length to include this bit and one proper
 	 * sign bit if needed. */
-      if (bits_[tlen] != sign) tlen += 1;
+      if (get(tlen) != sign) tlen += 1;
       tlen += 1;
 
 	/* Trim the bits if needed. */
-      if (tlen < nbits_) {
-	    V* tbits = new V[tlen];
-	    for (unsigned idx = 0; idx < tlen; idx += 1)
-		  tbits[idx] = bits_[idx];
-	    delete[] bits_;
-	    bits_ = tbits;
-	    nbits_ = tlen;
-      }
+      if (tlen < nbits_)
+	    resize_(tlen);
 }
 
 verinum::verinum(const verinum&that)
 {
       string_flag_ = that.string_flag_;
-      nbits_ = that.nbits_;
-      bits_ = new V[nbits_];
       has_len_ = that.has_len_;
       has_sign_ = that.has_sign_;
       is_single_ = that.is_single_;
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    bits_[idx] = that.bits_[idx];
+      alloc_(that.nbits_);
+      for (unsigned idx = 0 ;  idx < 2*nwords_(nbits_) ;  idx += 1)
+	    abits_[idx] = that.abits_[idx];
 }
 
 verinum::verinum(const verinum&that, unsigned nbits)
 {
       string_flag_ = that.string_flag_ && (that.nbits_ == nbits);
-      nbits_ = nbits;
-      bits_ = new V[nbits_];
       has_len_ = true;
       has_sign_ = that.has_sign_;
       is_single_ = false;
+      alloc_(nbits);
 
       unsigned copy = nbits;
       if (copy > that.nbits_)
 	    copy = that.nbits_;
-      for (unsigned idx = 0 ;  idx < copy ;  idx += 1)
-	    bits_[idx] = that.bits_[idx];
-
-      if (copy < nbits_) {
-	    if (has_sign_ || that.is_single_) {
-		  for (unsigned idx = copy ;  idx < nbits_ ;  idx += 1)
-			bits_[idx] = bits_[idx-1];
-	    } else {
-		  for (unsigned idx = copy ;  idx < nbits_ ;  idx += 1)
-			bits_[idx] = verinum::V0;
-	    }
+      for (unsigned idx = 0 ;  idx < nwords_(copy) ;  idx += 1) {
+	    abits_[idx] = that.abits_[idx];
+	    bbits_[idx] = that.bbits_[idx];
       }
+      mask_tail_();
+
+	// Signed values are padded with the top bit. Otherwise the
+	// pad is the 0 that is already there.
+      if (copy < nbits_ && copy > 0 && (has_sign_ || that.is_single_))
+	    fill_(copy, get(copy-1));
 }
 
 verinum::verinum(int64_t that)
@@ -321,34 +290,33 @@ verinum::verinum(int64_t that)
 
       if (that < 0) tmp = (that+1)/2;
       else tmp = that/2;
-      nbits_ = 1;
+      unsigned nbits = 1;
       while (tmp != 0) {
-	    nbits_ += 1;
+	    nbits += 1;
 	    tmp /= 2;
       }
 
-      nbits_ += 1;
+      nbits += 1;
 
-      bits_ = new V[nbits_];
+      alloc_(nbits);
       for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    bits_[idx] = (that & 1)? V1 : V0;
+	    if (that & 1) set(idx, V1);
 	    that >>= 1;
       }
 }
 
 verinum::~verinum()
 {
-      delete[]bits_;
+      delete[]abits_;
 }
 
 verinum& verinum::operator= (const verinum&that)
 {
       if (this == &that) return *this;
-      delete[]bits_;
-      nbits_ = that.nbits_;
-      bits_ = new V[that.nbits_];
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    bits_[idx] = that.bits_[idx];
+      delete[]abits_;
+      alloc_(that.nbits_);
+      for (unsigned idx = 0 ;  idx < 2*nwords_(nbits_) ;  idx += 1)
+	    abits_[idx] = that.abits_[idx];
 
       has_len_ = that.has_len_;
       has_sign_ = that.has_sign_;
@@ -357,23 +325,135 @@ verinum& verinum::operator= (const verinum&that)
       return *this;
 }
 
+/*
+ * Allocate zeroed planes for nbits bits. Any previous storage is
+ * not released.
+ */
+void verinum::alloc_(unsigned nbits)
+{
+      nbits_ = nbits;
+      unsigned nwords = nwords_(nbits);
+      if (nwords == 0) {
+	    abits_ = 0;
+	    bbits_ = 0;
+	    return;
+      }
+
+      abits_ = new unsigned long[2*nwords];
+      bbits_ = abits_ + nwords;
+      for (unsigned idx = 0 ;  idx < 2*nwords ;  idx += 1)
+	    abits_[idx] = 0;
+}
+
+/*
+ * Change the width, keeping the low bits and zero extending.
+ */
+void verinum::resize_(unsigned nbits)
+{
+      unsigned long*old_abits = abits_;
+      unsigned long*old_bbits = bbits_;
+      unsigned copy = nwords_(nbits < nbits_? nbits : nbits_);
+
+      alloc_(nbits);
+      for (unsigned idx = 0 ;  idx < copy ;  idx += 1) {
+	    abits_[idx] = old_abits[idx];
+	    bbits_[idx] = old_bbits[idx];
+      }
+      mask_tail_();
+
+      delete[]old_abits;
+}
+
+/*
+ * Set all the bits from off to the end to the value val.
+ */
+void verinum::fill_(unsigned off, V val)
+{
+      if (off >= nbits_)
+	    return;
+
+      unsigned long afill = (val & 1)? -1UL : 0;
+      unsigned long bfill = (val & 2)? -1UL : 0;
+      unsigned word = off / BITS_PER_WORD;
+      unsigned long mask = -1UL << (off % BITS_PER_WORD);
+
+      abits_[word] = (abits_[word] & ~mask) | (afill & mask);
+      bbits_[word] = (bbits_[word] & ~mask) | (bfill & mask);
+      for (unsigned idx = word+1 ;  idx < nwords_(nbits_) ;  idx += 1) {
+	    abits_[idx] = afill;
+	    bbits_[idx] = bfill;
+      }
+      mask_tail_();
+}
+
+void verinum::mask_tail_()
+{
+      if (unsigned tail = nbits_ % BITS_PER_WORD) {
+	    unsigned long mask = -1UL >> (BITS_PER_WORD - tail);
+	    abits_[nwords_(nbits_)-1] &= mask;
+	    bbits_[nwords_(nbits_)-1] &= mask;
+      }
+}
+
+/*
+ * Get the value as 2-state words. The caller must know that the value
+ * is defined. The value is truncated or extended to nwords words.
+ */
+void verinum::get_words_(unsigned long*val, unsigned nwords, bool sign_ext) const
+{
+      unsigned own = nwords_(nbits_);
+      bool neg = sign_ext && nbits_ > 0 && get(nbits_-1) == V1;
+
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+	    val[idx] = idx < own? abits_[idx] : neg? -1UL : 0;
+
+      if (neg && own <= nwords && (nbits_ % BITS_PER_WORD))
+	    val[own-1] |= -1UL << (nbits_ % BITS_PER_WORD);
+}
+
+/*
+ * Set the value from 2-state words. The val array holds at least as
+ * many words as this number, and bits past the width are ignored.
+ */
+void verinum::set_words_(const unsigned long*val)
+{
+      unsigned nwords = nwords_(nbits_);
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    abits_[idx] = val[idx];
+	    bbits_[idx] = 0;
+      }
+      mask_tail_();
+}
+
 verinum::V verinum::get(unsigned idx) const
 {
       assert(idx < nbits_);
-      return bits_[idx];
+      unsigned long mask = 1UL << (idx % BITS_PER_WORD);
+      unsigned word = idx / BITS_PER_WORD;
+      return (V) (((abits_[word] & mask)? 1 : 0) | ((bbits_[word] & mask)? 2 : 0));
 }
 
 verinum::V verinum::set(unsigned idx, verinum::V val)
 {
       assert(idx < nbits_);
-      return bits_[idx] = val;
+      unsigned long mask = 1UL << (idx % BITS_PER_WORD);
+      unsigned word = idx / BITS_PER_WORD;
+      if (val & 1)
+	    abits_[word] |= mask;
+      else
+	    abits_[word] &= ~mask;
+      if (val & 2)
+	    bbits_[word] |= mask;
+      else
+	    bbits_[word] &= ~mask;
+      return val;
 }
 
 void verinum::set(unsigned off, const verinum&val)
 {
       assert(off + val.len() <= nbits_);
       for (unsigned idx = 0 ; idx < val.len() ; idx += 1)
-	    bits_[off+idx] = val[idx];
+	    set(off+idx, val[idx]);
 }
 
 unsigned long verinum::as_ulong() const
@@ -384,17 +464,7 @@ unsigned long verinum::as_ulong() const
       if (!is_defined())
 	    return 0;
 
-      unsigned top = nbits_;
-      if (top >= (8 * sizeof(unsigned long)))
-	  top = 8 * sizeof(unsigned long);
-
-      unsigned long val = 0;
-      unsigned long mask = 1;
-      for (unsigned idx = 0 ;  idx < top ;  idx += 1, mask <<= 1)
-	    if (bits_[idx] == V1)
-		  val |= mask;
-
-      return val;
+      return abits_[0];
 }
 
 uint64_t verinum::as_ulong64() const
@@ -405,15 +475,10 @@ uint64_t verinum::as_ulong64() const
       if (!is_defined())
 	    return 0;
 
-      unsigned top = nbits_;
-      if (top >= (8 * sizeof(uint64_t)))
-	  top = 8 * sizeof(uint64_t);
-
       uint64_t val = 0;
-      uint64_t mask = 1;
-      for (unsigned idx = 0 ;  idx < top ;  idx += 1, mask <<= 1)
-	    if (bits_[idx] == V1)
-		  val |= mask;
+      unsigned nwords = nwords_(nbits_);
+      for (unsigned idx = 0 ;  idx < nwords && idx*BITS_PER_WORD < 64 ;  idx += 1)
+	    val |= (uint64_t)abits_[idx] << (idx*BITS_PER_WORD);
 
       return val;
 }
@@ -448,26 +513,26 @@ signed long verinum::as_long() const
       }
       int lost_bits=0;
 
-      if (has_sign_ && (bits_[nbits_-1] == V1)) {
+      if (has_sign_ && (get(nbits_-1) == V1)) {
 	    val = -1;
 	    signed long mask = ~1L;
 	    for (unsigned idx = 0 ;  idx < top ;  idx += 1) {
-		  if (bits_[idx] == V0) val &= mask;
+		  if (get(idx) == V0) val &= mask;
 		  mask = (mask << 1) | 1L;
 	    }
 	    if (diag_top) {
 		  for (unsigned idx = top; idx < diag_top; idx += 1) {
-			if (bits_[idx] == V0) lost_bits=1;
+			if (get(idx) == V0) lost_bits=1;
 		  }
 	    }
       } else {
 	    signed long mask = 1;
 	    for (unsigned idx = 0 ;  idx < top ;  idx += 1, mask <<= 1) {
-		  if (bits_[idx] == V1) val |= mask;
+		  if (get(idx) == V1) val |= mask;
 	    }
 	    if (diag_top) {
 		  for (unsigned idx = top; idx < diag_top; idx += 1) {
-			if (bits_[idx] == V1) lost_bits=1;
+			if (get(idx) == V1) lost_bits=1;
 		  }
 	    }
       }
@@ -484,17 +549,17 @@ double verinum::as_double() const
 
       double val = 0.0;
         /* Do we have/want a signed value? */
-      if (has_sign_ && bits_[nbits_-1] == V1) {
+      if (has_sign_ && get(nbits_-1) == V1) {
 	    V carry = V1;
 	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  V sum = add_with_carry(~bits_[idx], V0, carry);
+		  V sum = add_with_carry(~get(idx), V0, carry);
 		  if (sum == V1)
 			val += pow(2.0, (double)idx);
 	    }
 	    val *= -1.0;
       } else {
 	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  if (bits_[idx] == V1)
+		  if (get(idx) == V1)
 			val += pow(2.0, (double)idx);
 	    }
       }
@@ -510,16 +575,9 @@ string verinum::as_string() const
       string res;
       for (unsigned idx = nbits_ ;  idx > 0 ;  idx -= 8) {
 	    char char_val = 0;
-	    V*bp = bits_+idx;
-
-	    if (*(--bp) == V1) char_val |= 0x80;
-	    if (*(--bp) == V1) char_val |= 0x40;
-	    if (*(--bp) == V1) char_val |= 0x20;
-	    if (*(--bp) == V1) char_val |= 0x10;
-	    if (*(--bp) == V1) char_val |= 0x08;
-	    if (*(--bp) == V1) char_val |= 0x04;
-	    if (*(--bp) == V1) char_val |= 0x02;
-	    if (*(--bp) == V1) char_val |= 0x01;
+	    for (unsigned bit = 0 ;  bit < 8 ;  bit += 1) {
+		  if (get(idx-8+bit) == V1) char_val |= 1 << bit;
+	    }
 
 	    if (char_val == '"' || char_val == '\\') {
 		  char tmp[5];
@@ -542,39 +600,39 @@ bool verinum::is_before(const verinum&that) const
       if (that.nbits_ < nbits_) return false;
 
       for (unsigned idx = nbits_  ;  idx > 0 ;  idx -= 1) {
-	    if (bits_[idx-1] < that.bits_[idx-1]) return true;
-	    if (bits_[idx-1] > that.bits_[idx-1]) return false;
+	    if (get(idx-1) < that.get(idx-1)) return true;
+	    if (get(idx-1) > that.get(idx-1)) return false;
       }
       return false;
 }
 
 bool verinum::is_defined() const
 {
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    if (bits_[idx] == Vx) return false;
-	    if (bits_[idx] == Vz) return false;
+      for (unsigned idx = 0 ;  idx < nwords_(nbits_) ;  idx += 1) {
+	    if (bbits_[idx]) return false;
       }
       return true;
 }
 
 bool verinum::is_zero() const
 {
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    if (bits_[idx] != V0) return false;
+      for (unsigned idx = 0 ;  idx < 2*nwords_(nbits_) ;  idx += 1)
+	    if (abits_[idx]) return false;
 
       return true;
 }
 
 bool verinum::is_negative() const
 {
-      return (bits_[nbits_-1] == V1) && has_sign();
+      return nbits_ > 0 && (get(nbits_-1) == V1) && has_sign();
 }
 
 void verinum::cast_to_int2()
 {
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    if (bits_[idx] == Vx || bits_[idx] == Vz)
-		  bits_[idx] = V0;
+	// Vx and Vz both become V0.
+      for (unsigned idx = 0 ;  idx < nwords_(nbits_) ;  idx += 1) {
+	    abits_[idx] &= ~bbits_[idx];
+	    bbits_[idx] = 0;
       }
 }
 
@@ -968,23 +1026,174 @@ static verinum::V add_with_carry(verinum::V l, verinum::V r, verinum::V&c)
 
 verinum v_not(const verinum&left)
 {
+	// V0 and V1 are inverted, and Vx and Vz both become Vx.
       verinum val = left;
-      for (unsigned idx = 0 ;  idx < val.len() ;  idx += 1)
-	    switch (val[idx]) {
-		case verinum::V0:
-		  val.set(idx, verinum::V1);
-		  break;
-		case verinum::V1:
-		  val.set(idx, verinum::V0);
-		  break;
-		default:
-		  val.set(idx, verinum::Vx);
-		  break;
-	    }
+      for (unsigned idx = 0 ;  idx < verinum::nwords_(val.nbits_) ;  idx += 1)
+	    val.abits_[idx] = ~(val.abits_[idx] | val.bbits_[idx]);
+      val.mask_tail_();
 
       return val;
 }
 
+/*
+ * These are the word level helpers for arithmetic on defined
+ * values. The arrays are of unsigned long, least significant word
+ * first. Products are done in half words so that they fit in a
+ * native unsigned long.
+ */
+static const unsigned HALF_BITS = 4 * sizeof(unsigned long);
+static const unsigned long HALF_MASK = (1UL << HALF_BITS) - 1;
+
+static void multiply_word(unsigned long a, unsigned long b,
+			  unsigned long&low, unsigned long&high)
+{
+      unsigned long al = a & HALF_MASK, ah = a >> HALF_BITS;
+      unsigned long bl = b & HALF_MASK, bh = b >> HALF_BITS;
+      unsigned long ll = al * bl;
+      unsigned long lh = al * bh;
+      unsigned long hl = ah * bl;
+      unsigned long mid = (ll >> HALF_BITS) + (lh & HALF_MASK) + (hl & HALF_MASK);
+      low = (ll & HALF_MASK) | (mid << HALF_BITS);
+      high = ah * bh + (lh >> HALF_BITS) + (hl >> HALF_BITS) + (mid >> HALF_BITS);
+}
+
+/*
+ * res = the low nwords words of a*b, where a and b are also nwords
+ * long. The res array must not overlap the inputs.
+ */
+static void multiply_words(unsigned long*res, const unsigned long*a,
+			   const unsigned long*b, unsigned nwords)
+{
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+	    res[idx] = 0;
+
+      for (unsigned bdx = 0 ;  bdx < nwords ;  bdx += 1) {
+	    if (b[bdx] == 0)
+		  continue;
+
+	    unsigned long carry = 0;
+	    for (unsigned adx = 0 ;  adx+bdx < nwords ;  adx += 1) {
+		  unsigned long low, high;
+		  multiply_word(a[adx], b[bdx], low, high);
+		  low += carry;
+		  if (low < carry) high += 1;
+		  res[adx+bdx] += low;
+		  if (res[adx+bdx] < low) high += 1;
+		  carry = high;
+	    }
+      }
+}
+
+/*
+ * Divide a by b, both nwords long, using Knuth's Algorithm D
+ * ("Seminumerical Algorithms", section 4.3.1) on half word digits.
+ * The quotient and remainder are written last, so they may overlap
+ * the inputs. The divisor must not be zero.
+ */
+static void divide_words(unsigned long*quot, unsigned long*rem,
+			 const unsigned long*a, const unsigned long*b,
+			 unsigned nwords)
+{
+      const unsigned long BASE = 1UL << HALF_BITS;
+
+      const unsigned ndig = 2 * nwords;
+      std::vector<unsigned long> u (ndig+1), v (ndig+1);
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    u[2*idx+0] = a[idx] & HALF_MASK;
+	    u[2*idx+1] = a[idx] >> HALF_BITS;
+	    v[2*idx+0] = b[idx] & HALF_MASK;
+	    v[2*idx+1] = b[idx] >> HALF_BITS;
+      }
+
+      unsigned m = ndig;
+      while (m > 0 && u[m-1] == 0)
+	    m -= 1;
+      unsigned n = ndig;
+      while (n > 0 && v[n-1] == 0)
+	    n -= 1;
+      assert(n > 0);
+
+      std::vector<unsigned long> q (ndig+1, 0), r (ndig+1, 0);
+
+      if (m < n) {
+	    for (unsigned idx = 0 ;  idx < m ;  idx += 1)
+		  r[idx] = u[idx];
+
+      } else if (n == 1) {
+	    unsigned long k = 0;
+	    for (unsigned jdx = m ;  jdx > 0 ;  jdx -= 1) {
+		  unsigned long tmp = (k << HALF_BITS) | u[jdx-1];
+		  q[jdx-1] = tmp / v[0];
+		  k = tmp - q[jdx-1] * v[0];
+	    }
+	    r[0] = k;
+
+      } else {
+	      // Normalize so that the top divisor digit has its high
+	      // bit set.
+	    unsigned sh = 0;
+	    while ((v[n-1] << sh & (BASE >> 1)) == 0)
+		  sh += 1;
+
+	    std::vector<unsigned long> vn (n), un (m+1);
+	    for (unsigned idx = n-1 ;  idx > 0 ;  idx -= 1)
+		  vn[idx] = ((v[idx] << sh) | (v[idx-1] >> (HALF_BITS-sh))) & HALF_MASK;
+	    vn[0] = (v[0] << sh) & HALF_MASK;
+
+	    un[m] = u[m-1] >> (HALF_BITS-sh);
+	    for (unsigned idx = m-1 ;  idx > 0 ;  idx -= 1)
+		  un[idx] = ((u[idx] << sh) | (u[idx-1] >> (HALF_BITS-sh))) & HALF_MASK;
+	    un[0] = (u[0] << sh) & HALF_MASK;
+
+	    for (unsigned jdx = m-n+1 ;  jdx > 0 ;  jdx -= 1) {
+		  const unsigned j = jdx - 1;
+
+		  unsigned long num = (un[j+n] << HALF_BITS) | un[j+n-1];
+		  unsigned long qhat = num / vn[n-1];
+		  unsigned long rhat = num - qhat * vn[n-1];
+		  while (qhat >= BASE
+			 || qhat * vn[n-2] > ((rhat << HALF_BITS) | un[j+n-2])) {
+			qhat -= 1;
+			rhat += vn[n-1];
+			if (rhat >= BASE)
+			      break;
+		  }
+
+		  long k = 0;
+		  long t;
+		  for (unsigned idx = 0 ;  idx < n ;  idx += 1) {
+			unsigned long p = qhat * vn[idx];
+			t = (long)un[idx+j] - k - (long)(p & HALF_MASK);
+			un[idx+j] = (unsigned long)t & HALF_MASK;
+			k = (long)(p >> HALF_BITS) - (t >> HALF_BITS);
+		  }
+		  t = (long)un[j+n] - k;
+		  un[j+n] = (unsigned long)t & HALF_MASK;
+
+		  q[j] = qhat;
+		  if (t < 0) {
+			q[j] -= 1;
+			unsigned long c = 0;
+			for (unsigned idx = 0 ;  idx < n ;  idx += 1) {
+			      unsigned long tmp = un[idx+j] + vn[idx] + c;
+			      un[idx+j] = tmp & HALF_MASK;
+			      c = tmp >> HALF_BITS;
+			}
+			un[j+n] = (un[j+n] + c) & HALF_MASK;
+		  }
+	    }
+
+	    for (unsigned idx = 0 ;  idx < n-1 ;  idx += 1)
+		  r[idx] = ((un[idx] >> sh) | (un[idx+1] << (HALF_BITS-sh))) & HALF_MASK;
+	    r[n-1] = un[n-1] >> sh;
+      }
+
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    if (quot) quot[idx] = q[2*idx+0] | (q[2*idx+1] << HALF_BITS);
+	    if (rem)  rem[idx]  = r[2*idx+0] | (r[2*idx+1] << HALF_BITS);
+      }
+}
+
 /*
  * Addition works a bit at a time, from the least significant up to
  * the most significant. The result is signed only if both of the
@@ -1001,6 +1210,28 @@ verinum operator + (const verinum&left, const verinum&right)
       if (right.len() > max) max = right.len();
 
       bool signed_flag = left.has_sign() && right.has_sign();
+
+	// Defined values are added a word at a time.
+      if (min > 0 && left.is_defined() && right.is_defined()) {
+	    unsigned nwords = verinum::nwords_(max+1);
+	    std::vector<unsigned long> lw (nwords), rw (nwords);
+	    left.get_words_(&lw[0], nwords, signed_flag);
+	    right.get_words_(&rw[0], nwords, signed_flag);
+
+	    unsigned long carry = 0;
+	    for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+		  unsigned long sum = lw[idx] + carry;
+		  carry = sum < carry? 1 : 0;
+		  lw[idx] = sum + rw[idx];
+		  if (lw[idx] < sum) carry = 1;
+	    }
+
+	    verinum val (verinum::V0, max+1, false);
+	    val.set_words_(&lw[0]);
+	    val.has_sign(signed_flag);
+	    return val;
+      }
+
       verinum::V*val_bits = new verinum::V[max+1];
 
       verinum::V carry = verinum::V0;
@@ -1045,6 +1276,40 @@ verinum operator - (const verinum&left, const verinum&right)
       if (right.len() > max) max = right.len();
 
       bool signed_flag = left.has_sign() && right.has_sign();
+
+	// Defined values are subtracted a word at a time.
+      if (min > 0 && left.is_defined() && right.is_defined()) {
+	    unsigned nwords = verinum::nwords_(max+1);
+	    std::vector<unsigned long> lw (nwords), rw (nwords);
+	    left.get_words_(&lw[0], nwords, signed_flag);
+	    right.get_words_(&rw[0], nwords, signed_flag);
+
+	    unsigned long borrow = 0;
+	    for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+		  unsigned long dif = lw[idx] - borrow;
+		  borrow = lw[idx] < borrow? 1 : 0;
+		  if (dif < rw[idx]) borrow = 1;
+		  lw[idx] = dif - rw[idx];
+	    }
+
+	      // A signed result keeps the extra bit only if it is
+	      // needed to hold the sign.
+	    unsigned wid = max;
+	    if (signed_flag) {
+		  unsigned long top = lw[max/verinum::BITS_PER_WORD]
+			>> (max%verinum::BITS_PER_WORD);
+		  unsigned long next = lw[(max-1)/verinum::BITS_PER_WORD]
+			>> ((max-1)%verinum::BITS_PER_WORD);
+		  if ((top ^ next) & 1)
+			wid += 1;
+	    }
+
+	    verinum val (verinum::V0, wid, false);
+	    val.set_words_(&lw[0]);
+	    val.has_sign(signed_flag);
+	    return val;
+      }
+
       verinum::V*val_bits = new verinum::V[max+1];
 
       verinum::V carry = verinum::V1;
@@ -1084,8 +1349,8 @@ verinum operator - (const verinum&left, const verinum&right)
  * result. The resulting number is as large as the sum of the sizes of
  * the operand.
  *
- * The algorithm used is successive shift and add operations,
- * implemented as the nested loops.
+ * The operands are extended to the width of the result and
+ * multiplied a word at a time.
  *
  * If either value is not completely defined, then the result is not
  * defined either.
@@ -1106,21 +1371,15 @@ verinum operator * (const verinum&left, const verinum&right)
       verinum result(verinum::V0, left.len() + right.len(), has_len_flag);
       result.has_sign(left.has_sign() || right.has_sign());
 
-      verinum::V r_sign = sign_bit(right);
-      for (unsigned rdx = 0 ;  rdx < result.len() ;  rdx += 1) {
-
-	    verinum::V r_bit = rdx < right.len()? right.get(rdx) : r_sign;
-	    if (r_bit == verinum::V0)
-		  continue;
-
-	    verinum::V l_sign = sign_bit(left);
-	    verinum::V carry = verinum::V0;
-	    for (unsigned ldx = 0 ;  ldx < result.len()-rdx ;  ldx += 1) {
-		  verinum::V l_bit = ldx < left.len()? left[ldx] : l_sign;
-		  result.set(ldx+rdx, add_with_carry(l_bit,
-						     result[rdx+ldx],
-						     carry));
-	    }
+	// Extend each operand to the width of the result, and keep
+	// the low words of the product.
+      unsigned nwords = verinum::nwords_(result.len());
+      if (nwords > 0) {
+	    std::vector<unsigned long> lw (nwords), rw (nwords), res (nwords);
+	    left.get_words_(&lw[0], nwords, left.has_sign());
+	    right.get_words_(&rw[0], nwords, right.has_sign());
+	    multiply_words(&res[0], &lw[0], &rw[0], nwords);
+	    result.set_words_(&res[0]);
       }
 
       return trim_vnum(result);
@@ -1169,8 +1428,22 @@ verinum pow(const verinum&left, const verinum&right)
 	    }
       }
 
-      for (long idx = 1 ;  idx < pow_count ;  idx += 1)
-	    result = result * left;
+	// Multiply in the remaining pow_count-1 factors of left by
+	// repeated squaring. The product widths add up the same way
+	// no matter how the factors are grouped, so the result is the
+	// same as multiplying the factors in one at a time.
+      if (pow_count > 1) {
+	    verinum base = left;
+	    unsigned long count = pow_count - 1;
+	    for (;;) {
+		  if (count & 1)
+			result = result * base;
+		  count >>= 1;
+		  if (count == 0)
+			break;
+		  base = base * base;
+	    }
+      }
 
       return result;
 }
@@ -1209,7 +1482,13 @@ verinum operator >> (const verinum&that, unsigned shift)
       return result;
 }
 
-static verinum unsigned_divide(verinum num, verinum den, bool signed_result)
+/*
+ * Divide two defined, non-negative values. The quotient is as wide
+ * as needed for the significant bits of the operands, plus a sign
+ * bit if the result is to be signed.
+ */
+verinum verinum::unsigned_divide_(const verinum&num, const verinum&den,
+				  bool signed_result)
 {
       unsigned nwid = num.len();
       while (nwid > 0 && (num.get(nwid-1) == verinum::V0))
@@ -1222,28 +1501,31 @@ static verinum unsigned_divide(verinum num, verinum den, bool signed_result)
       if (dwid > nwid)
 	    return verinum(verinum::V0, 1);
 
-      den = den << (nwid-dwid);
-
       unsigned idx = nwid - dwid + 1;
       verinum result (verinum::V0, signed_result ? idx + 1 : idx);
-      if (signed_result) {
-	    result.set(idx, verinum::V0);
+      if (signed_result)
 	    result.has_sign(true);
-      }
-      while (idx > 0) {
-	    if (den <= num) {
-		  verinum dif = num - den;
-		  num = dif;
-		  result.set(idx-1, verinum::V1);
-	    }
-	    den = den >> 1;
-	    idx -= 1;
-      }
+
+	// The buffers are sized for the result, which may be a bit
+	// wider than the numerator.
+      unsigned nwords = nwords_(nwid);
+      std::vector<unsigned long> nw (nwords_(nwid+1)), dw (nwords);
+      num.get_words_(&nw[0], nwords, false);
+      den.get_words_(&dw[0], nwords, false);
+      divide_words(&nw[0], 0, &nw[0], &dw[0], nwords);
+
+	// The quotient fits in idx bits, so the top bit of a signed
+	// result stays 0.
+      result.set_words_(&nw[0]);
 
       return result;
 }
 
-static verinum unsigned_modulus(verinum num, verinum den)
+/*
+ * The remainder of two defined, non-negative values. The result has
+ * an indefinite length, so that the caller can trim it.
+ */
+verinum verinum::unsigned_modulus_(const verinum&num, const verinum&den)
 {
       unsigned nwid = num.len();
       while (nwid > 0 && (num.get(nwid-1) == verinum::V0))
@@ -1256,19 +1538,37 @@ static verinum unsigned_modulus(verinum num, verinum den)
       if (dwid > nwid)
 	    return num;
 
-      den = den << (nwid-dwid);
-
-      unsigned idx = nwid - dwid + 1;
-      while (idx > 0) {
-	    if (den <= num) {
-		  verinum dif = num - den;
-		  num = dif;
-	    }
-	    den = den >> 1;
-	    idx -= 1;
+      unsigned nwords = nwords_(nwid);
+      std::vector<unsigned long> nw (nwords), dw (nwords), qw (nwords);
+      num.get_words_(&nw[0], nwords, false);
+      den.get_words_(&dw[0], nwords, false);
+      divide_words(&qw[0], &dw[0], &nw[0], &dw[0], nwords);
+
+	// If the denominator does not divide in at all, then the
+	// remainder is the numerator itself.
+      unsigned qtop = nwords * BITS_PER_WORD;
+      while (qtop > 0) {
+	    unsigned bit = qtop - 1;
+	    if ((qw[bit/BITS_PER_WORD] >> (bit%BITS_PER_WORD)) & 1)
+		  break;
+	    qtop = bit;
       }
+      if (qtop == 0)
+	    return num;
+
+	// Otherwise the remainder is as wide as the widest of the
+	// numerator and the denominator shifted up to the top bit of
+	// the quotient, as if it was made by shift and subtract.
+      unsigned wid = den.len() + qtop - 1;
+      if (wid < num.len())
+	    wid = num.len();
 
-      return num;
+      dw.resize(nwords_(wid), 0);
+      verinum result (verinum::V0, wid, false);
+      result.set_words_(&dw[0]);
+      result.has_sign(num.has_sign() && den.has_sign());
+
+      return result;
 }
 
 /*
@@ -1332,7 +1632,7 @@ verinum operator / (const verinum&left, const verinum&right)
 		  } else {
 			use_right = right;
 		  }
-		  result = unsigned_divide(use_left, use_right, true);
+		  result = verinum::unsigned_divide_(use_left, use_right, true);
 		  if (negative) result = zero - result;
 	    }
 
@@ -1350,7 +1650,7 @@ verinum operator / (const verinum&left, const verinum&right)
 		  }
 
 	    } else {
-		  result = unsigned_divide(left, right, false);
+		  result = verinum::unsigned_divide_(left, right, false);
 	    }
       }
 
@@ -1409,7 +1709,7 @@ verinum operator % (const verinum&left, const verinum&right)
 		  } else {
 			use_right = right;
 		  }
-		  result = unsigned_modulus(use_left, use_right);
+		  result = verinum::unsigned_modulus_(use_left, use_right);
 		  result.has_sign(true);
 		  if (negative) result = zero - result;
 	    }
@@ -1424,7 +1724,7 @@ verinum operator % (const verinum&left, const verinum&right)
 			v >>= 1;
 		  }
 	    } else {
-		  result = unsigned_modulus(left, right);
+		  result = verinum::unsigned_modulus_(left, right);
 	    }
       }
 
@@ -38,6 +38,13 @@ using namespace std;
  */
 class verinum {
 
+      friend verinum operator + (const verinum&, const verinum&);
+      friend verinum operator - (const verinum&, const verinum&);
+      friend verinum operator * (const verinum&, const verinum&);
+      friend verinum operator / (const verinum&, const verinum&);
+      friend verinum operator % (const verinum&, const verinum&);
+      friend verinum v_not(const verinum&);
+
     public:
       enum V { V0 = 0, V1, Vx, Vz };
 
@@ -107,7 +114,29 @@ class verinum {
       void signed_trim();
 
     private:
-      V* bits_;
+	// The bits are packed into machine words in two planes. The
+	// abits_ hold the low bit of each V value and the bbits_ hold
+	// the high bit, so V0 is 00, V1 is 01, Vx is 10 and Vz is
+	// 11. Both planes share one allocation, and the bits past
+	// nbits_ in the top word are always 0.
+      enum { BITS_PER_WORD = 8 * sizeof(unsigned long) };
+      static unsigned nwords_(unsigned nbits)
+      { return (nbits + BITS_PER_WORD - 1) / BITS_PER_WORD; }
+
+      void alloc_(unsigned nbits);
+      void resize_(unsigned nbits);
+      void fill_(unsigned off, V val);
+      void mask_tail_();
+	// Word access to the 2-state value of a defined number.
+      void get_words_(unsigned long*val, unsigned nwords, bool sign_ext) const;
+      void set_words_(const unsigned long*val);
+
+      static verinum unsigned_divide_(const verinum&num, const verinum&den,
+				      bool signed_result);
+      static verinum unsigned_modulus_(const verinum&num, const verinum&den);
+
+      unsigned long*abits_;
+      unsigned long*bbits_;
       unsigned nbits_;
       bool has_len_;
       bool has_sign_;
@@ -22,6 +22,7 @@
 # include  <string.h>
 # include  <stdlib.h>
 # include  <stdio.h>
+# include  <limits.h>
 # include  <assert.h>
 # include  "sys_readmem_lex.h"
 # include  <sys/stat.h>
@@ -341,15 +342,36 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       while ((code = readmemlex()) != 0) {
 	  switch (code) {
 	  case MEM_ADDRESS:
-	      addr = value.value.vector->aval;
-	      if (addr < min_addr || addr > max_addr) {
+		/* Check the full address before narrowing it to the
+		   int that the memory index uses, so that large file
+		   addresses are not wrapped into the memory range. */
+	      if (readmem_address_overflow ||
+	          readmem_address > (PLI_UINT64)INT_MAX ||
+	          (int)readmem_address < min_addr ||
+	          (int)readmem_address > max_addr) {
 		  vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
 		             (int)vpi_get(vpiLineNo, callh));
-		  vpi_printf("%s(%s): address (0x%x) is out of range "
-		             "[0x%x:0x%x]\n",
-			     name, fname, addr, start_addr, stop_addr);
+		  if (readmem_address_overflow) {
+			vpi_printf("%s(%s): address is too large for the "
+			           "range [0x%x:0x%x]\n", name, fname,
+			           start_addr, stop_addr);
+		  } else if (readmem_address >> 32) {
+			  /* Print the 64 bit address in hex, as the high
+			     and low words, to match the other messages. */
+			vpi_printf("%s(%s): address (0x%x%08x) is out of "
+			           "range [0x%x:0x%x]\n", name, fname,
+			           (unsigned)(readmem_address >> 32),
+			           (unsigned)(readmem_address & 0xffffffff),
+			           start_addr, stop_addr);
+		  } else {
+			vpi_printf("%s(%s): address (0x%x) is out of range "
+			           "[0x%x:0x%x]\n", name, fname,
+			           (unsigned)readmem_address,
+			           start_addr, stop_addr);
+		  }
 		  goto bailout;
 	      }
+	      addr = (int)readmem_address;
 		/* if there is an address in the memory file, then
 		   turn off any possible warnings about not having
 		   enough words to load the memory. This is standard
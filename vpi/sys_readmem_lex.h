@@ -28,6 +28,11 @@
 
 extern char *readmem_error_token;
 
+/* The address of the last MEM_ADDRESS token. The overflow flag is set
+   if the address did not fit in 64 bits. */
+extern PLI_UINT64 readmem_address;
+extern int readmem_address_overflow;
+
 extern void sys_readmem_start_file(FILE*in, int bin_flag,
 				   unsigned width, struct t_vpi_vecval*val);
 extern int readmemlex();
@@ -477,7 +477,7 @@ void vvp_arith_pow::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 		  return;
 	    }
 
-	    vvp_vector2_t result = pow(a2, b2);
+	    vvp_vector2_t result = pow(a2, b2, wid_);
 	    res4 = vector2_to_vector4(result, wid_);
       }
 
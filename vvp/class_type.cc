@@ -20,6 +20,7 @@
 # include  "class_type.h"
 # include  "compile.h"
 # include  "vpi_priv.h"
+# include  "statistics.h"
 # include  "config.h"
 # include  <map>
 #ifdef CHECK_WITH_VALGRIND
@@ -29,6 +30,9 @@
 
 using namespace std;
 
+unsigned long count_cobjects = 0;
+unsigned long count_cobject_pool = 0;
+
 /*
  * This class_property_t class is an abstract base class for
  * representing a property of an instance. The definition keeps and
@@ -191,6 +195,33 @@ class property_logic : public class_property_t {
       size_t wid_;
 };
 
+/*
+ * A 2-state vector that fits in a single word is kept inline in the
+ * instance instead of in a vvp_vector2_t, which would need its own
+ * heap allocation for every instance of the class.
+ */
+class property_bit_word : public class_property_t {
+    public:
+      inline property_bit_word(size_t wid): wid_(wid) { }
+      ~property_bit_word() { }
+
+      size_t instance_size() const { return sizeof(unsigned long); }
+
+    public:
+      void construct(char*buf) const
+      { unsigned long*tmp = reinterpret_cast<unsigned long*> (buf+offset_);
+	*tmp = 0;
+      }
+
+      void set_vec4(char*buf, const vvp_vector4_t&val);
+      void get_vec4(char*buf, vvp_vector4_t&val);
+
+      void copy(char*dst, char*src);
+
+    private:
+      size_t wid_;
+};
+
 template <class T> class property_real : public class_property_t {
     public:
       inline explicit property_real(void) { }
@@ -303,6 +334,43 @@ void property_bit::copy(char*dst, char*src)
       *dst_obj = *src_obj;
 }
 
+void property_bit_word::set_vec4(char*buf, const vvp_vector4_t&val)
+{
+      unsigned long*obj = reinterpret_cast<unsigned long*> (buf+offset_);
+      unsigned wid = val.size() < wid_? val.size() : wid_;
+
+      if (wid == 0) {
+	    *obj = 0;
+	    return;
+      }
+
+	// The common case has no X or Z bits and can be moved as a
+	// word. Otherwise X and Z bits become 0, as for a vvp_vector2_t.
+      if (val.subarray(obj, 0, wid))
+	    return;
+
+      unsigned long tmp = 0;
+      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
+	    if (val.value(idx) == BIT4_1)
+		  tmp |= 1UL << idx;
+      }
+      *obj = tmp;
+}
+
+void property_bit_word::get_vec4(char*buf, vvp_vector4_t&val)
+{
+      unsigned long*obj = reinterpret_cast<unsigned long*> (buf+offset_);
+      val = vvp_vector4_t(wid_);
+      val.setarray(0, wid_, obj);
+}
+
+void property_bit_word::copy(char*dst, char*src)
+{
+      unsigned long*dst_obj = reinterpret_cast<unsigned long*> (dst+offset_);
+      unsigned long*src_obj = reinterpret_cast<unsigned long*> (src+offset_);
+      *dst_obj = *src_obj;
+}
+
 void property_logic::set_vec4(char*buf, const vvp_vector4_t&val)
 {
       vvp_vector4_t*obj = reinterpret_cast<vvp_vector4_t*> (buf+offset_);
@@ -374,8 +442,8 @@ void property_object::get_object(char*buf, vvp_object_t&val)
 
 void property_object::copy(char*dst, char*src)
 {
-      vvp_object_t*dst_obj = reinterpret_cast<vvp_object_t*>(dst);
-      vvp_object_t*src_obj = reinterpret_cast<vvp_object_t*>(src);
+      vvp_object_t*dst_obj = reinterpret_cast<vvp_object_t*>(dst+offset_);
+      vvp_object_t*src_obj = reinterpret_cast<vvp_object_t*>(src+offset_);
       *dst_obj = *src_obj;
 }
 
@@ -385,6 +453,16 @@ class_type::class_type(const string&nam, size_t nprop)
 : class_name_(nam), properties_(nprop)
 {
       instance_size_ = 0;
+      pool_ = 0;
+}
+
+class_type::~class_type()
+{
+      while (pool_) {
+	    char*buf = pool_;
+	    pool_ = *reinterpret_cast<char**> (buf);
+	    delete[]buf;
+      }
 }
 
 void class_type::set_property(size_t idx, const string&name, const string&type)
@@ -416,7 +494,10 @@ void class_type::set_property(size_t idx, const string&name, const string&type)
 	    properties_[idx].type = new property_object;
       else if (type[0] == 'b') {
 	    size_t wid = strtoul(type.c_str()+1, 0, 0);
-	    properties_[idx].type = new property_bit(wid);
+	    if (wid <= 8*sizeof(unsigned long))
+		  properties_[idx].type = new property_bit_word(wid);
+	    else
+		  properties_[idx].type = new property_bit(wid);
       } else if (type[0] == 'L') {
 	    size_t wid = strtoul(type.c_str()+1,0,0);
 	    properties_[idx].type = new property_logic(wid);
@@ -438,7 +519,12 @@ void class_type::finish_setup(void)
 	    size_map[instance_size].push_back(idx);
       }
 
-      instance_size_ = accum;
+	// Round the instance up so that a free instance can hold the
+	// pool link, and so that pooled buffers keep their alignment.
+      const size_t link_size = sizeof(char*);
+      if (accum < link_size)
+	    accum = link_size;
+      instance_size_ = (accum + link_size - 1) / link_size * link_size;
 
 	// Now allocate the properties to offsets within an instance
 	// space. Allocate the properties largest objects first so
@@ -456,9 +542,22 @@ void class_type::finish_setup(void)
       }
 }
 
+/*
+ * Instances of a class tend to be created and destroyed at a high
+ * rate, and they all have the same size, so deleted instances are kept
+ * in a per-class free list and reused by the next instance_new.
+ */
 class_type::inst_t class_type::instance_new() const
 {
-      char*buf = new char [instance_size_];
+      char*buf;
+      count_cobjects += 1;
+      if (pool_) {
+	    buf = pool_;
+	    pool_ = *reinterpret_cast<char**> (buf);
+      } else {
+	    buf = new char [instance_size_];
+	    count_cobject_pool += 1;
+      }
 
       for (size_t idx = 0 ; idx < properties_.size() ; idx += 1)
 	    properties_[idx].type->construct(buf);
@@ -473,7 +572,8 @@ void class_type::instance_delete(class_type::inst_t obj) const
       for (size_t idx = 0 ; idx < properties_.size() ; idx += 1)
 	    properties_[idx].type->destruct(buf);
 
-      delete[]buf;
+      *reinterpret_cast<char**> (buf) = pool_;
+      pool_ = buf;
 }
 
 void class_type::set_vec4(class_type::inst_t obj, size_t pid,
@@ -39,6 +39,7 @@ class class_type : public __vpiHandle {
 
     public:
       explicit class_type(const std::string&nam, size_t nprop);
+      ~class_type();
 
 	// This is the name of the class type.
       inline const std::string&class_name(void) const { return class_name_; }
@@ -82,6 +83,9 @@ class class_type : public __vpiHandle {
       };
       std::vector<prop_t> properties_;
       size_t instance_size_;
+	// Free list of deleted instances, linked through their
+	// first word.
+      mutable char*pool_;
 };
 
 #endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026 The Icarus Verilog contributors
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "compile.h"
+# include  "parse_misc.h"
+# include  "schedule.h"
+# include  "vvp_net_sig.h"
+# include  <cstdlib>
+# include  <cassert>
+
+/*
+ * A vvp_clock_gen is the run time form of a free running clock,
+ *
+ *     always #N clk = ~clk;
+ *
+ * It is a generic event that, every N time units, reads the current
+ * value of the variable, inverts it and writes it back to port 0 of
+ * the variable, exactly as the thread would. It then schedules itself
+ * again, so there is no thread to wake and no code to execute.
+ *
+ * The event is first scheduled at time 0, in the place the thread
+ * would have been scheduled, and that first run only schedules the
+ * first toggle, like the %delay of the thread. So the toggles land in
+ * the same place in the event queue as the thread wakeups did.
+ */
+class vvp_clock_gen : public vvp_gen_event_s {
+
+    public:
+      explicit vvp_clock_gen(vvp_time64_t half_period);
+      ~vvp_clock_gen();
+
+      void run_run();
+
+	// The variable, resolved after the .clock statement is
+	// compiled.
+      vvp_net_t*net;
+
+    private:
+      vvp_time64_t half_period_;
+      vvp_signal_value*sig_;
+      bool started_;
+};
+
+vvp_clock_gen::vvp_clock_gen(vvp_time64_t half_period)
+: net(0), half_period_(half_period), sig_(0), started_(false)
+{
+      assert(half_period_ > 0);
+}
+
+vvp_clock_gen::~vvp_clock_gen()
+{
+}
+
+void vvp_clock_gen::run_run()
+{
+      if (! started_) {
+	    started_ = true;
+	    schedule_generic(this, half_period_, false);
+	    return;
+      }
+
+      if (sig_ == 0) {
+	    assert(net);
+	    sig_ = dynamic_cast<vvp_signal_value*> (net->fil);
+	    assert(sig_);
+      }
+
+      vvp_vector4_t val;
+      sig_->vec4_value(val);
+
+      vvp_net_ptr_t ptr (net, 0);
+      vvp_send_vec4(ptr, ~val, 0);
+
+      schedule_generic(this, half_period_, false);
+}
+
+void compile_clock(char*label, unsigned long delay_lo, unsigned long delay_hi)
+{
+      vvp_time64_t delay = ((vvp_time64_t)delay_hi << 32) | delay_lo;
+      if (delay == 0) {
+	    yyerror(".clock delay must be greater than zero");
+	    free(label);
+	    return;
+      }
+
+      vvp_clock_gen*clk = new vvp_clock_gen(delay);
+      functor_ref_lookup(&clk->net, label);
+
+	/* Start the clock at time 0 in the place of the .thread that
+	   it replaces. The first run schedules the first toggle. */
+      schedule_generic(clk, 0, false);
+}
@@ -744,6 +744,10 @@ void compile_cleanup(void)
       compile_island_cleanup();
       compile_array_cleanup();
 
+	/* All the nets are linked now, so their fanout can be
+	   copied into arrays as they are used. */
+      vvp_net_t::fanout_ready();
+
       if (verbose_flag) {
 	    fprintf(stderr, " ... Compiletf functions\n");
 	    fflush(stderr);
@@ -457,6 +457,13 @@ extern void compile_scope_recall(char*sym);
  */
 extern void compile_thread(char*start_sym, char*flag);
 
+/*
+ * This function creates a free running clock that inverts the
+ * variable named by the label every delay_hi:delay_lo time units.
+ */
+extern void compile_clock(char*label, unsigned long delay_lo,
+			  unsigned long delay_hi);
+
 /*
  * This function is called to create a var vector with the given name.
  *
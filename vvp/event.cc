@@ -226,11 +226,19 @@ vvp_fun_edge::~vvp_fun_edge()
 bool vvp_fun_edge::recv_vec4_(const vvp_vector4_t&bit,
                               vvp_bit4_t&old_bit, vthread_t&threads)
 {
+      vvp_bit4_t new_bit = bit.value(0);
+
+	/* Clock nets are mostly scalars that are sent the same value
+	   again and again. A value that did not change is never an
+	   edge, so skip the edge table entirely. */
+      if (new_bit == old_bit && edge_ != vvp_edge_none)
+	    return false;
+
 	/* See what kind of edge this represents. */
-      edge_t mask = VVP_EDGE(old_bit, bit.value(0));
+      edge_t mask = VVP_EDGE(old_bit, new_bit);
 
 	/* Save the current input for the next time around. */
-      old_bit = bit.value(0);
+      old_bit = new_bit;
 
       if ((edge_ == vvp_edge_none) || (edge_ & mask)) {
 	    run_waiting_threads_(threads);
@@ -276,6 +284,34 @@ void vvp_fun_edge_sa::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       }
 }
 
+vvp_fun_edge_scalar_sa::vvp_fun_edge_scalar_sa(edge_t e)
+: vvp_fun_edge_sa(e), mask_(e)
+{
+      assert(e != vvp_edge_none);
+}
+
+vvp_fun_edge_scalar_sa::~vvp_fun_edge_scalar_sa()
+{
+}
+
+void vvp_fun_edge_scalar_sa::recv_vec4(vvp_net_ptr_t port,
+				       const vvp_vector4_t&bit,
+				       vvp_context_t)
+{
+      assert(port.port() == 0);
+
+      vvp_bit4_t new_bit = bit.value(0);
+      vvp_bit4_t old_bit = bits_[0];
+      if (new_bit == old_bit)
+	    return;
+
+      bits_[0] = new_bit;
+      if (mask_ & VVP_EDGE(old_bit, new_bit)) {
+	    run_waiting_threads_(threads_);
+	    port.ptr()->send_vec4(bit, 0);
+      }
+}
+
 vvp_fun_edge_aa::vvp_fun_edge_aa(edge_t e)
 : vvp_fun_edge(e)
 {
@@ -789,6 +825,8 @@ void compile_event(char*label, char*type, unsigned argc, struct symb_s*argv)
 
             if (vpip_peek_current_scope()->is_automatic) {
                   fun = new vvp_fun_edge_aa(edge);
+            } else if (argc == 1 && edge != vvp_edge_none) {
+                  fun = new vvp_fun_edge_scalar_sa(edge);
             } else {
                   fun = new vvp_fun_edge_sa(edge);
             }
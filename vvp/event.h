@@ -187,10 +187,29 @@ class vvp_fun_edge_sa : public vvp_fun_edge {
 			unsigned base, unsigned wid, unsigned vwid,
 			vvp_context_t context);
 
-    private:
+    protected:
       vthread_t threads_;
 };
 
+/*
+ * Statically allocated vvp_fun_edge for the common case of a single
+ * posedge or negedge input, such as @(posedge clk). It reads bit 0 of
+ * the input directly and tests the transition against the edge mask
+ * in one step.
+ */
+class vvp_fun_edge_scalar_sa : public vvp_fun_edge_sa {
+
+    public:
+      explicit vvp_fun_edge_scalar_sa(edge_t e);
+      virtual ~vvp_fun_edge_scalar_sa();
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t context);
+
+    private:
+      edge_t mask_;
+};
+
 /*
  * Automatically allocated vvp_fun_edge.
  */
@@ -21,18 +21,50 @@
 # include  "compile.h"
 # include  "symbols.h"
 # include  "schedule.h"
+# include  "statistics.h"
 # include  <list>
+# include  <map>
+# include  <vector>
+# include  <algorithm>
 
 # include  <iostream>
 
 using namespace std;
 
+unsigned long count_island_runs = 0;
+unsigned long count_island_branches = 0;
+
+struct vvp_island_branch_tran;
+
 class vvp_island_tran : public vvp_island {
 
     public:
+      vvp_island_tran();
+
       void run_island();
       void count_drivers(vvp_island_port*port, unsigned bit_idx,
                          unsigned counts[3]);
+
+    private:
+      void setup_();
+      void retest_port_(vvp_island_port*port,
+			vector<vvp_island_port*>&seeds);
+      void collect_component_(vvp_island_port*seed,
+			      vector<vvp_island_branch_tran*>&touched);
+
+	// This is set up the first time the island is run.
+      bool setup_done_;
+	// All the branches, in the order of the branches_ list.
+      vector<vvp_island_branch_tran*> all_branches_;
+	// A branch end at the node of each port that has branches.
+      map<vvp_island_port*,vvp_branch_ptr_t> nodes_;
+	// The branches that each enable port controls.
+      map<vvp_island_port*,vector<vvp_island_branch_tran*> > enables_;
+	// Enable ports whose output changed in the last run. The
+	// branches they control are tested again in the next run.
+      vector<vvp_island_port*> retest_;
+	// The mark for ports and branches visited in this run.
+      unsigned long mark_;
 };
 
 enum tran_state_t {
@@ -47,13 +79,21 @@ struct vvp_island_branch_tran : public vvp_island_branch {
                              unsigned width__, unsigned part__,
                              unsigned offset__);
       bool run_test_enabled();
-      void run_resolution();
-      void run_output();
+      void run_resolution(unsigned long use_mark);
+      bool run_output(unsigned long use_mark, vvp_island_port*port,
+		      vvp_net_t*net);
 
       vvp_net_t*en;
       unsigned width, part, offset;
       bool active_high;
       tran_state_t state;
+
+	// These are filled in when the island is set up.
+      vvp_island_port*a_port;
+      vvp_island_port*b_port;
+      vvp_island_port*en_port;
+      unsigned order;
+      unsigned long mark;
 };
 
 vvp_island_branch_tran::vvp_island_branch_tran(vvp_net_t*en__,
@@ -62,47 +102,208 @@ vvp_island_branch_tran::vvp_island_branch_tran(vvp_net_t*en__,
                                                unsigned part__,
                                                unsigned offset__)
 : en(en__), width(width__), part(part__), offset(offset__),
-  active_high(active_high__)
+  active_high(active_high__), a_port(0), b_port(0), en_port(0),
+  order(0), mark(0)
 {
       state = en__ ? tran_disabled : tran_enabled;
 }
 
+/*
+ * Only tran branches are ever added to a tran island, so the cast
+ * does not need to be checked at run time.
+ */
 static inline vvp_island_branch_tran* BRANCH_TRAN(vvp_island_branch*tmp)
 {
-      vvp_island_branch_tran*res = dynamic_cast<vvp_island_branch_tran*>(tmp);
-      assert(res);
-      return res;
+      return static_cast<vvp_island_branch_tran*>(tmp);
+}
+
+static inline vvp_island_port* PORT(vvp_net_t*net)
+{
+      return static_cast<vvp_island_port*>(net->fun);
+}
+
+vvp_island_tran::vvp_island_tran()
+: setup_done_(false), mark_(0)
+{
+}
+
+/*
+ * Cache the port pointers of all the branches, and build the maps
+ * that the run_island() method uses to find the parts of the island
+ * that need to be run again.
+ */
+void vvp_island_tran::setup_()
+{
+      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
+	    vvp_island_branch_tran*tmp = BRANCH_TRAN(cur);
+	    tmp->a_port = PORT(tmp->a);
+	    tmp->b_port = PORT(tmp->b);
+	    tmp->en_port = tmp->en? dynamic_cast<vvp_island_port*>(tmp->en->fun) : 0;
+	    tmp->order = all_branches_.size();
+	    all_branches_.push_back(tmp);
+
+	    if (nodes_.find(tmp->a_port) == nodes_.end())
+		  nodes_[tmp->a_port] = vvp_branch_ptr_t(tmp, 0);
+	    if (nodes_.find(tmp->b_port) == nodes_.end())
+		  nodes_[tmp->b_port] = vvp_branch_ptr_t(tmp, 1);
+	    if (tmp->en_port)
+		  enables_[tmp->en_port].push_back(tmp);
+      }
+
+      setup_done_ = true;
+}
+
+static inline bool branch_order(const vvp_island_branch_tran*a,
+				const vvp_island_branch_tran*b)
+{
+      return a->order < b->order;
+}
+
+/*
+ * Test again the enables of the branches controlled by this port. If
+ * a branch changes state, then the ports on both ends need to be
+ * resolved again.
+ */
+void vvp_island_tran::retest_port_(vvp_island_port*port,
+				   vector<vvp_island_port*>&seeds)
+{
+      map<vvp_island_port*,vector<vvp_island_branch_tran*> >::iterator cur
+	    = enables_.find(port);
+      if (cur == enables_.end())
+	    return;
+
+      vector<vvp_island_branch_tran*>&list = cur->second;
+      for (size_t idx = 0 ;  idx < list.size() ;  idx += 1) {
+	    vvp_island_branch_tran*tmp = list[idx];
+	    tran_state_t old_state = tmp->state;
+	    tmp->run_test_enabled();
+	    if (tmp->state == old_state)
+		  continue;
+
+	    seeds.push_back(tmp->a_port);
+	    seeds.push_back(tmp->b_port);
+      }
+}
+
+/*
+ * Mark all the ports that are currently connected to the seed port
+ * through branches that are not disabled, and collect all the
+ * branches that touch those ports. Ports already marked in this run
+ * are already part of a collected component.
+ */
+void vvp_island_tran::collect_component_(vvp_island_port*seed,
+					 vector<vvp_island_branch_tran*>&touched)
+{
+      if (seed->mark == mark_)
+	    return;
+
+      map<vvp_island_port*,vvp_branch_ptr_t>::iterator node = nodes_.find(seed);
+      if (node == nodes_.end())
+	    return;
+
+      seed->mark = mark_;
+      vector<vvp_branch_ptr_t> stack;
+      stack.push_back(node->second);
+
+      while (! stack.empty()) {
+	    vvp_branch_ptr_t cur = stack.back();
+	    stack.pop_back();
+
+	    vvp_branch_ptr_t idx = cur;
+	    do {
+		  vvp_island_branch_tran*tmp = BRANCH_TRAN(idx.ptr());
+		  if (tmp->mark != mark_) {
+			tmp->mark = mark_;
+			touched.push_back(tmp);
+		  }
+
+		  if (tmp->state == tran_disabled)
+			continue;
+
+		  unsigned dst_ab = idx.port() ^ 1;
+		  vvp_island_port*dst = dst_ab? tmp->b_port : tmp->a_port;
+		  if (dst->mark == mark_)
+			continue;
+
+		  dst->mark = mark_;
+		  stack.push_back(vvp_branch_ptr_t(tmp, dst_ab));
+	    } while ((idx = next(idx)) != cur);
+      }
 }
 
 /*
  * The run_island() method is called by the scheduler to run the
- * entire island. We run the island by calling run_resolution() for
- * all the branches in the island.
+ * island. The values of the ports in a group of ports that are
+ * connected together through enabled branches depend only on the
+ * inputs to those ports, so only the groups that contain a port that
+ * flagged the island, or a branch that changed state, are resolved
+ * again. The first run resolves the entire island.
+ *
+ * The branches of the groups are resolved and output in the order of
+ * the branches_ list, which is the order in which the entire island
+ * is run, so the values and the order of the outputs are the same as
+ * when running the entire island.
 */
 void vvp_island_tran::run_island()
 {
-	// Test to see if any of the branches are enabled. This loop
-	// tests the enabled inputs for all the branches and caches
-	// the results in the state for each branch.
-      bool runnable = false;
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    runnable |= tmp->run_test_enabled();
-      }
+      count_island_runs += 1;
+      mark_ += 1;
 
-	// Now resolve all the branches in the island.
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    tmp->run_resolution();
+      vector<vvp_island_port*> seeds;
+      vector<vvp_island_branch_tran*> touched;
+
+      if (! setup_done_) {
+	    setup_();
+
+	    for (size_t idx = 0 ;  idx < all_branches_.size() ;  idx += 1) {
+		  vvp_island_branch_tran*tmp = all_branches_[idx];
+		  tmp->run_test_enabled();
+		  tmp->mark = mark_;
+		  tmp->a_port->mark = mark_;
+		  tmp->b_port->mark = mark_;
+	    }
+	    touched = all_branches_;
+
+	    for (size_t idx = 0 ;  idx < flagged_ports_.size() ;  idx += 1)
+		  flagged_ports_[idx]->flagged = false;
+	    flagged_ports_.clear();
+
+      } else {
+	      // The flagged ports are resolved again, and if they are
+	      // enables, the branches they control are tested again.
+	    for (size_t idx = 0 ;  idx < flagged_ports_.size() ;  idx += 1) {
+		  vvp_island_port*port = flagged_ports_[idx];
+		  port->flagged = false;
+		  seeds.push_back(port);
+		  retest_port_(port, seeds);
+	    }
+	    flagged_ports_.clear();
+
+	    for (size_t idx = 0 ;  idx < retest_.size() ;  idx += 1)
+		  retest_port_(retest_[idx], seeds);
+	    retest_.clear();
+
+	    for (size_t idx = 0 ;  idx < seeds.size() ;  idx += 1)
+		  collect_component_(seeds[idx], touched);
+
+	    sort(touched.begin(), touched.end(), branch_order);
       }
 
+      count_island_branches += touched.size();
+
+	// Now resolve the collected branches.
+      for (size_t idx = 0 ;  idx < touched.size() ;  idx += 1)
+	    touched[idx]->run_resolution(mark_);
+
 	// Now output the resolved values.
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    tmp->run_output();
+      for (size_t idx = 0 ;  idx < touched.size() ;  idx += 1) {
+	    vvp_island_branch_tran*tmp = touched[idx];
+	    if (tmp->run_output(mark_, tmp->a_port, tmp->a)
+		&& enables_.find(tmp->a_port) != enables_.end())
+		  retest_.push_back(tmp->a_port);
+	    if (tmp->run_output(mark_, tmp->b_port, tmp->b)
+		&& enables_.find(tmp->b_port) != enables_.end())
+		  retest_.push_back(tmp->b_port);
       }
 }
 
@@ -185,7 +386,7 @@ void vvp_island_tran::count_drivers(vvp_island_port*port, unsigned bit_idx,
 
 bool vvp_island_branch_tran::run_test_enabled()
 {
-      vvp_island_port*ep = en? dynamic_cast<vvp_island_port*> (en->fun) : 0;
+      vvp_island_port*ep = en_port;
 
 	// If there is no ep port (no "enabled" input) then this is a
 	// tran branch. Assume it is always enabled.
@@ -276,7 +477,7 @@ static void push_value_through_branch(const vvp_vector8_t&val,
       unsigned dst_ab = src_ab^1;
 
       vvp_net_t*dst_net = dst_ab? branch->b : branch->a;
-      vvp_island_port*dst_port = dynamic_cast<vvp_island_port*>(dst_net->fun);
+      vvp_island_port*dst_port = dst_ab? branch->b_port : branch->a_port;
 
       vvp_vector8_t old_val = dst_port->value;
 
@@ -333,17 +534,18 @@ static void push_value_through_branches(const vvp_vector8_t&val,
 /*
  * This method resolves the value for a branch recursively. It uses
  * recursive descent to span the graph of branches, pushing values
- * through the network until a stable state is reached.
+ * through the network until a stable state is reached. Only the
+ * ports marked with use_mark are being resolved in this run.
  */
-void vvp_island_branch_tran::run_resolution()
+void vvp_island_branch_tran::run_resolution(unsigned long use_mark)
 {
       list<vvp_branch_ptr_t> connections;
       vvp_island_port*port;
 
 	// If the A side port hasn't already been visited, then push
         // its input value through all the branches connected to it.
-      port = dynamic_cast<vvp_island_port*>(a->fun);
-      if (port->value.size() == 0) {
+      port = a_port;
+      if (port->mark == use_mark && port->value.size() == 0) {
 	    vvp_branch_ptr_t a_side(this, 0);
 	    island_collect_node(connections, a_side);
 
@@ -357,8 +559,8 @@ void vvp_island_branch_tran::run_resolution()
 	// Do the same for the B side port. Note that if the branch
         // is enabled, the B side port will have already been visited
         // when we resolved the A side port.
-      port = dynamic_cast<vvp_island_port*>(b->fun);
-      if (port->value.size() == 0) {
+      port = b_port;
+      if (port->mark == use_mark && port->value.size() == 0) {
 	    vvp_branch_ptr_t b_side(this, 1);
 	    island_collect_node(connections, b_side);
 
@@ -370,24 +572,21 @@ void vvp_island_branch_tran::run_resolution()
       }
 }
 
-void vvp_island_branch_tran::run_output()
+/*
+ * Send the resolved value of the port (one end of this branch) to
+ * the output, if it hasn't already been sent. Return true if the
+ * output of the port changed.
+ */
+bool vvp_island_branch_tran::run_output(unsigned long use_mark,
+					vvp_island_port*port, vvp_net_t*net)
 {
-      vvp_island_port*port;
+      if (port->mark != use_mark || port->value.size() == 0)
+	    return false;
 
-	// If the A side port hasn't already been updated, send the
-        // resolved value to the output.
-      port = dynamic_cast<vvp_island_port*>(a->fun);
-      if (port->value.size() != 0) {
-	    island_send_value(a, port->value);
-	    port->value = vvp_vector8_t::nil;
-      }
-
-	// Do the same for the B side port.
-      port = dynamic_cast<vvp_island_port*>(b->fun);
-      if (port->value.size() != 0) {
-	    island_send_value(b, port->value);
-	    port->value = vvp_vector8_t::nil;
-      }
+      bool changed = ! port->outvalue.eeq(port->value);
+      island_send_value(net, port->value);
+      port->value = vvp_vector8_t::nil;
+      return changed;
 }
 
 void compile_island_tran(char*label)
@@ -227,6 +227,7 @@ static void final_cleanup()
       signal_pool_delete();
       vvp_net_pool_delete();
       ufunc_pool_delete();
+      vthread_pool_delete();
 #endif
 	/*
 	 * Unload the VPI modules. This is essential for MinGW, to ensure
@@ -524,18 +525,22 @@ int main(int argc, char*argv[])
 		    count_thread_events);
 	    vpi_mcd_printf(1, "    %8lu assign events\n",
 		    count_assign_events);
-	    vpi_mcd_printf(1, "             ...assign(vec4) pool=%lu\n",
-			   count_assign4_pool());
 	    vpi_mcd_printf(1, "             ...assign(vec8) pool=%lu\n",
 			   count_assign8_pool());
 	    vpi_mcd_printf(1, "             ...assign(real) pool=%lu\n",
 			   count_assign_real_pool());
-	    vpi_mcd_printf(1, "             ...assign(word) pool=%lu\n",
-			   count_assign_aword_pool());
 	    vpi_mcd_printf(1, "             ...assign(word/r) pool=%lu\n",
 			   count_assign_arword_pool());
 	    vpi_mcd_printf(1, "    %8lu other events (pool=%lu)\n",
 			   count_gen_events, count_gen_pool());
+	    vpi_mcd_printf(1, "    %8lu class objects (pool=%lu)\n",
+			   count_cobjects, count_cobject_pool);
+	    vpi_mcd_printf(1, "    %8lu island runs (branches resolved=%lu)\n",
+			   count_island_runs, count_island_branches);
+	    vpi_mcd_printf(1, "    %8lu net fanout arrays\n",
+			   count_fanout_arrays);
+	    vpi_mcd_printf(1, "    %8lu var array pages allocated\n",
+			   count_var_array_pages);
       }
 
       final_cleanup();
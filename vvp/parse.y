@@ -79,7 +79,7 @@ static struct __vpiModPath*modpath_dst = 0;
 %token K_ARITH_SUM K_ARITH_SUM_R K_ARITH_POW K_ARITH_POW_R K_ARITH_POW_S
 %token K_ARRAY K_ARRAY_2U K_ARRAY_2S K_ARRAY_I K_ARRAY_R K_ARRAY_S K_ARRAY_STR K_ARRAY_PORT
 %token K_CAST_INT K_CAST_REAL K_CAST_REAL_S K_CAST_2
-%token K_CLASS
+%token K_CLASS K_CLOCK
 %token K_CMP_EEQ K_CMP_EQ K_CMP_EQ_R K_CMP_NEE K_CMP_NE K_CMP_NE_R
 %token K_CMP_GE K_CMP_GE_R K_CMP_GE_S K_CMP_GT K_CMP_GT_R K_CMP_GT_S
 %token K_CONCAT K_CONCAT8 K_DEBUG K_DELAY K_DFF
@@ -698,6 +698,12 @@ statement
 	|         K_THREAD T_SYMBOL ',' T_SYMBOL ';'
 		{ compile_thread($2, $4); }
 
+  /* The .clock statement replaces the thread of a free running
+     clock. The numbers are the low and high words of the delay. */
+
+	|         K_CLOCK T_SYMBOL ',' T_NUMBER ',' T_NUMBER ';'
+		{ compile_clock($2, $4, $6); }
+
   /* Var statements declare a bit of a variable. This also implicitly
      creates a functor with the same name that acts as the output of
      the variable in the netlist. */
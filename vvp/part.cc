@@ -57,15 +57,25 @@ void vvp_fun_part_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 {
       assert(port.port() == 0);
 
-      vvp_vector4_t tmp (wid_, BIT4_X);
-      for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
-	    if (idx + base_ < bit.size())
-		  tmp.set_bit(idx, bit.value(base_+idx));
-      }
-      if (val_ .eeq( tmp ))
-	    return;
+	// If the part is entirely within the input vector, then test
+	// for a change by comparing the part in place, a word at a
+	// time, and only build the new value if it did change.
+      if (base_ + wid_ <= bit.size()) {
+	    if (val_.size() == wid_ && bit.eeq_part(base_, val_))
+		  return;
+	    val_ = bit.subvalue(base_, wid_);
 
-      val_ = tmp;
+      } else {
+	    vvp_vector4_t tmp (wid_, BIT4_X);
+	    for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
+		  if (idx + base_ < bit.size())
+			tmp.set_bit(idx, bit.value(base_+idx));
+	    }
+	    if (val_ .eeq( tmp ))
+		  return;
+
+	    val_ = tmp;
+      }
 
       if (net_ == 0) {
 	    net_ = port.ptr();
@@ -140,6 +150,14 @@ void vvp_fun_part_aa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
             vvp_vector4_t*val = static_cast<vvp_vector4_t*>
                   (vvp_get_context_item(context, context_idx_));
 
+            if (base_ + wid_ <= bit.size()) {
+                  if (val->size() == wid_ && bit.eeq_part(base_, *val))
+                        return;
+                  *val = bit.subvalue(base_, wid_);
+                  port.ptr()->send_vec4(*val, context);
+                  return;
+            }
+
             vvp_vector4_t tmp (wid_, BIT4_X);
             for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
                   if (idx + base_ < bit.size())
@@ -259,6 +277,13 @@ bool vvp_fun_part_var::recv_vec4_(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	    break;
       }
 
+      if (base >= 0 && (unsigned)base + wid_ <= source.size()) {
+	    if (ref.size() == wid_ && source.eeq_part((unsigned)base, ref))
+		  return false;
+	    ref = source.subvalue((unsigned)base, wid_);
+	    return true;
+      }
+
       vvp_vector4_t res (wid_);
 
       for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1) {
@@ -28,6 +28,7 @@
 # include  <cstdlib>
 # include  <cassert>
 
+# include  <vector>
 # include  <iostream>
 
 unsigned long count_assign_events = 0;
@@ -66,12 +67,15 @@ void event_s::single_step_display(void)
       std::cerr << "event_s: Step into event " << typeid(*this).name() << std::endl;
 }
 
+struct assign_commit_s;
+
 struct event_time_s {
       event_time_s() {
 	    count_time_events += 1;
 	    start = 0;
 	    active = 0;
 	    nbassign = 0;
+	    nbcommit = 0;
 	    rwsync = 0;
 	    rosync = 0;
 	    del_thr = 0;
@@ -86,6 +90,10 @@ struct event_time_s {
       struct event_s*rosync;
       struct event_s*del_thr;
 
+	// If the tail of the nbassign list is a commit buffer, this
+	// points to it so that more assignments can be added to it.
+      struct assign_commit_s*nbcommit;
+
       struct event_time_s*next;
 
       static void* operator new (size_t);
@@ -159,65 +167,6 @@ void del_thr_event_s::single_step_display(void)
 	   << " scope=" << scope->vpi_get_str(vpiFullName) << endl;
 }
 
-struct assign_vector4_event_s  : public event_s {
-	/* The default constructor. */
-      assign_vector4_event_s(const vvp_vector4_t&that) : val(that) {
-	    base = 0;
-	    vwid = 0;
-      }
-	/* A constructor that makes the val directly. */
-      assign_vector4_event_s(const vvp_vector4_t&that, unsigned adr, unsigned wid)
-      : val(that,adr,wid) {
-	    base = 0;
-	    vwid = 0;
-      }
-
-	/* Where to do the assign. */
-      vvp_net_ptr_t ptr;
-	/* Value to assign. */
-      vvp_vector4_t val;
-	/* Offset of the part into the destination. */
-      unsigned base;
-	/* Width of the destination vector. */
-      unsigned vwid;
-      void run_run(void);
-      void single_step_display(void);
-
-      static void* operator new(size_t);
-      static void operator delete(void*);
-};
-
-void assign_vector4_event_s::run_run(void)
-{
-      count_assign_events += 1;
-      if (vwid > 0)
-	    vvp_send_vec4_pv(ptr, val, base, val.size(), vwid, 0);
-      else
-	    vvp_send_vec4(ptr, val, 0);
-}
-
-void assign_vector4_event_s::single_step_display(void)
-{
-      cerr << "assign_vector4_event: Propagate val=" << val
-	   << ", vwid=" << vwid << ", base=" << base << endl;
-}
-
-static const size_t ASSIGN4_CHUNK_COUNT = 524288 / sizeof(struct assign_vector4_event_s);
-static slab_t<sizeof(assign_vector4_event_s),ASSIGN4_CHUNK_COUNT> assign4_heap;
-
-inline void* assign_vector4_event_s::operator new(size_t size)
-{
-      assert(size == sizeof(assign_vector4_event_s));
-      return assign4_heap.alloc_slab();
-}
-
-void assign_vector4_event_s::operator delete(void*dptr)
-{
-      assign4_heap.free_slab(dptr);
-}
-
-unsigned long count_assign4_pool(void) { return assign4_heap.pool; }
-
 struct assign_vector8_event_s  : public event_s {
       vvp_net_ptr_t ptr;
       vvp_vector8_t val;
@@ -292,38 +241,103 @@ void assign_real_event_s::operator delete(void*dptr)
 
 unsigned long count_assign_real_pool(void) { return assignr_heap.pool; }
 
-struct assign_array_word_s  : public event_s {
+/*
+ * The assign_commit_s is a nonblocking assignment commit buffer. The
+ * vector and array word assignments that are scheduled back to back
+ * into the same time step are collected as records in a contiguous
+ * array instead of as separate events, and the whole array is then
+ * committed in one loop. The initialization and set vector events
+ * use the same records. The records are committed strictly in the
+ * order they were scheduled, so every assignment, including repeated
+ * writes to the same target, propagates just as a separate event
+ * would.
+ */
+struct assign_record_s {
+      assign_record_s() : mem(0), adr(0), base(0), vwid(0) { }
+
+	/* Where to do the assign. The mem is nil for vectors. */
+      vvp_net_ptr_t ptr;
       vvp_array_t mem;
       unsigned adr;
+	/* Offset of the part into the destination vector or word. */
+      unsigned base;
+	/* Width of the destination vector, or 0 for a full vector. */
+      unsigned vwid;
+	/* Value to assign. */
       vvp_vector4_t val;
-      unsigned off;
+};
+
+struct assign_commit_s  : public event_s {
+      assign_commit_s();
+      ~assign_commit_s();
+
+      vvp_vector4_t& record(vvp_net_ptr_t ptr, vvp_array_t mem, unsigned adr,
+			    unsigned base, unsigned vwid);
+
       void run_run(void);
+      void single_step_display(void);
 
-      static void* operator new(size_t);
-      static void operator delete(void*);
+    private:
+      std::vector<assign_record_s> recs_;
+      unsigned count_;
+
+	// The records of a finished buffer are kept for the next
+	// buffer, so that the array and the vector values in it need
+	// not be allocated again in each time step.
+      static std::vector<assign_record_s> spare_;
 };
 
-void assign_array_word_s::run_run(void)
+std::vector<assign_record_s> assign_commit_s::spare_;
+
+assign_commit_s::assign_commit_s()
 {
-      count_assign_events += 1;
-      array_set_word(mem, adr, off, val);
+      recs_.swap(spare_);
+      count_ = 0;
 }
 
-static const size_t ARRAY_W_CHUNK_COUNT = 8192 / sizeof(struct assign_array_word_s);
-static slab_t<sizeof(assign_array_word_s),ARRAY_W_CHUNK_COUNT> array_w_heap;
+assign_commit_s::~assign_commit_s()
+{
+      if (spare_.capacity() < recs_.capacity())
+	    recs_.swap(spare_);
+}
 
-inline void* assign_array_word_s::operator new (size_t size)
+vvp_vector4_t& assign_commit_s::record(vvp_net_ptr_t ptr, vvp_array_t mem,
+				       unsigned adr, unsigned base,
+				       unsigned vwid)
 {
-      assert(size == sizeof(assign_array_word_s));
-      return array_w_heap.alloc_slab();
+      if (count_ == recs_.size())
+	    recs_.push_back(assign_record_s());
+
+      assign_record_s&rec = recs_[count_];
+      rec.ptr = ptr;
+      rec.mem = mem;
+      rec.adr = adr;
+      rec.base = base;
+      rec.vwid = vwid;
+      count_ += 1;
+      return rec.val;
 }
 
-void assign_array_word_s::operator delete(void*ptr)
+void assign_commit_s::run_run(void)
 {
-      array_w_heap.free_slab(ptr);
+      for (unsigned idx = 0 ;  idx < count_ ;  idx += 1) {
+	    assign_record_s&rec = recs_[idx];
+	    count_assign_events += 1;
+	    if (rec.mem)
+		  array_set_word(rec.mem, rec.adr, rec.base, rec.val);
+	    else if (rec.vwid > 0)
+		  vvp_send_vec4_pv(rec.ptr, rec.val, rec.base,
+				   rec.val.size(), rec.vwid, 0);
+	    else
+		  vvp_send_vec4(rec.ptr, rec.val, 0);
+      }
 }
 
-unsigned long count_assign_aword_pool(void) { return array_w_heap.pool; }
+void assign_commit_s::single_step_display(void)
+{
+      cerr << "assign_commit: Propagate " << count_
+	   << " vector assignments" << endl;
+}
 
 /*
  * This class supports the propagation of vec4 outputs from a
@@ -493,6 +507,12 @@ static struct event_time_s* sched_list = 0;
  */
 static struct event_s* schedule_init_list = 0;
 
+/*
+ * If the tail of the initialization list is a commit buffer, this
+ * points to it so that more initial values can be added to it.
+ */
+static struct assign_commit_s* schedule_init_commit = 0;
+
 /*
  * This is the head of the list of final events.
  */
@@ -587,11 +607,8 @@ static void schedule_final_event(struct event_s*cur)
 typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_NBASSIGN,
 			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
 
-static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
-			    event_queue_t select_queue)
+static struct event_time_s* schedule_time_(vvp_time64_t delay)
 {
-      cur->next = cur;
-
       struct event_time_s*ctim = sched_list;
 
       if (sched_list == 0) {
@@ -644,6 +661,14 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 	    }
       }
 
+      return ctim;
+}
+
+static void schedule_queue_(struct event_s*cur, struct event_time_s*ctim,
+			    event_queue_t select_queue)
+{
+      cur->next = cur;
+
 	/* By this point, ctim is the event_time structure that is to
 	   receive the event at hand. Put the event in to the
 	   appropriate list for the kind of assign we have at hand. */
@@ -722,6 +747,12 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
       }
 }
 
+static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
+			    event_queue_t select_queue)
+{
+      schedule_queue_(cur, schedule_time_(delay), select_queue);
+}
+
 static void schedule_event_push_(struct event_s*cur)
 {
       if ((sched_list == 0) || (sched_list->delay > 0)) {
@@ -760,6 +791,14 @@ void schedule_vthread(vthread_t thr, vvp_time64_t delay, bool push_flag)
       }
 }
 
+void schedule_vthread_list(vthread_t thr)
+{
+      struct vthread_event_s*cur = new vthread_event_s;
+
+      cur->thr = thr;
+      schedule_event_(cur, 0, SEQ_ACTIVE);
+}
+
 void schedule_final_vthread(vthread_t thr)
 {
       struct vthread_event_s*cur = new vthread_event_s;
@@ -770,16 +809,32 @@ void schedule_final_vthread(vthread_t thr)
       schedule_final_event(cur);
 }
 
+/*
+ * Get the commit buffer that nonblocking assignments with the given
+ * delay go into. If the last nonblocking event of that time step is
+ * not a commit buffer, then start a new one so that the order of the
+ * nonblocking events is kept.
+ */
+static struct assign_commit_s* schedule_commit_(vvp_time64_t delay)
+{
+      struct event_time_s*ctim = schedule_time_(delay);
+
+      if (ctim->nbcommit && ctim->nbcommit == ctim->nbassign)
+	    return ctim->nbcommit;
+
+      struct assign_commit_s*cur = new assign_commit_s;
+      schedule_queue_(cur, ctim, SEQ_NBASSIGN);
+      ctim->nbcommit = cur;
+      return cur;
+}
+
 void schedule_assign_vector(vvp_net_ptr_t ptr,
 			    unsigned base, unsigned vwid,
 			    const vvp_vector4_t&bit,
 			    vvp_time64_t delay)
 {
-      struct assign_vector4_event_s*cur = new struct assign_vector4_event_s(bit);
-      cur->ptr = ptr;
-      cur->base = base;
-      cur->vwid = vwid;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+      struct assign_commit_s*cur = schedule_commit_(delay);
+      cur->record(ptr, 0, 0, base, vwid) = bit;
 }
 
 void schedule_assign_plucked_vector(vvp_net_ptr_t ptr,
@@ -787,12 +842,8 @@ void schedule_assign_plucked_vector(vvp_net_ptr_t ptr,
 				    const vvp_vector4_t&src,
 				    unsigned adr, unsigned wid)
 {
-      struct assign_vector4_event_s*cur
-	    = new struct assign_vector4_event_s(src,adr,wid);
-      cur->ptr = ptr;
-      cur->vwid = 0;
-      cur->base = 0;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+      struct assign_commit_s*cur = schedule_commit_(delay);
+      cur->record(ptr, 0, 0, 0, 0) = src.subvalue(adr, wid);
 }
 
 void schedule_propagate_plucked_vector(vvp_net_t*net,
@@ -812,12 +863,8 @@ void schedule_assign_array_word(vvp_array_t mem,
 				vvp_vector4_t val,
 				vvp_time64_t delay)
 {
-      struct assign_array_word_s*cur = new struct assign_array_word_s;
-      cur->mem = mem;
-      cur->adr = word_addr;
-      cur->off = off;
-      cur->val = val;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+      struct assign_commit_s*cur = schedule_commit_(delay);
+      cur->record(vvp_net_ptr_t(), mem, word_addr, off, 0) = val;
 }
 
 void schedule_assign_array_word(vvp_array_t mem,
@@ -834,10 +881,8 @@ void schedule_assign_array_word(vvp_array_t mem,
 
 void schedule_set_vector(vvp_net_ptr_t ptr, const vvp_vector4_t&bit)
 {
-      struct assign_vector4_event_s*cur = new struct assign_vector4_event_s(bit);
-      cur->ptr = ptr;
-      cur->base = 0;
-      cur->vwid = 0;
+      struct assign_commit_s*cur = new assign_commit_s;
+      cur->record(ptr, 0, 0, 0, 0) = bit;
       schedule_event_(cur, 0, SEQ_ACTIVE);
 }
 
@@ -859,11 +904,14 @@ void schedule_set_vector(vvp_net_ptr_t ptr, double bit)
 
 void schedule_init_vector(vvp_net_ptr_t ptr, vvp_vector4_t bit)
 {
-      struct assign_vector4_event_s*cur = new struct assign_vector4_event_s(bit);
-      cur->ptr = ptr;
-      cur->base = 0;
-      cur->vwid = 0;
-      schedule_init_event(cur);
+	/* Back to back initial values share a commit buffer, the same
+	   as nonblocking assignments do. */
+      if (schedule_init_commit == 0
+	  || schedule_init_commit != schedule_init_list) {
+	    schedule_init_commit = new assign_commit_s;
+	    schedule_init_event(schedule_init_commit);
+      }
+      schedule_init_commit->record(ptr, 0, 0, 0, 0) = bit;
 }
 
 void schedule_init_vector(vvp_net_ptr_t ptr, vvp_vector8_t bit)
@@ -1021,6 +1069,8 @@ void schedule_simulate(void)
 	    } else {
 		  schedule_init_list->next = cur->next;
 	    }
+	    if (cur == schedule_init_commit)
+		  schedule_init_commit = 0;
 	    cur->run_run();
 	    delete cur;
       }
@@ -1092,6 +1142,7 @@ void schedule_simulate(void)
 	    if (ctim->active == 0) {
 		  ctim->active = ctim->nbassign;
 		  ctim->nbassign = 0;
+		  ctim->nbcommit = 0;
 
 		  if (ctim->active == 0) {
 			ctim->active = ctim->rwsync;
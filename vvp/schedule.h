@@ -37,6 +37,14 @@ extern void schedule_vthread(vthread_t thr, vvp_time64_t delay,
 
 extern void schedule_final_vthread(vthread_t thr);
 
+/*
+ * Schedule a list of threads (linked through their wait_next
+ * pointers) that an event woke up. The caller has already marked the
+ * threads as scheduled. The whole list is run by a single event in
+ * the active queue of the current time step.
+ */
+extern void schedule_vthread_list(vthread_t thr);
+
 /*
  * Create an assignment event. The val passed here will be assigned to
  * the specified input when the delay times out. This is scheduled
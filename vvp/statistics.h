@@ -34,6 +34,7 @@ extern unsigned long count_functors_resolv;
 extern unsigned long count_functors_sig;
 extern unsigned long count_filters;
 extern unsigned long count_vvp_nets;
+extern unsigned long count_fanout_arrays;
 extern unsigned long count_vpi_nets;
 extern unsigned long count_vpi_scopes;
 
@@ -41,6 +42,7 @@ extern unsigned long count_net_arrays;
 extern unsigned long count_net_array_words;
 extern unsigned long count_var_arrays;
 extern unsigned long count_var_array_words;
+extern unsigned long count_var_array_pages;
 extern unsigned long count_real_arrays;
 extern unsigned long count_real_array_words;
 
@@ -49,15 +51,19 @@ extern unsigned long count_time_events;
 extern unsigned long count_time_pool(void);
 
 extern unsigned long count_assign_events;
-extern unsigned long count_assign4_pool(void);
 extern unsigned long count_assign8_pool(void);
 extern unsigned long count_assign_real_pool(void);
-extern unsigned long count_assign_aword_pool(void);
 extern unsigned long count_assign_arword_pool(void);
 
 extern unsigned long count_gen_events;
 extern unsigned long count_gen_pool(void);
 
+extern unsigned long count_cobjects;
+extern unsigned long count_cobject_pool;
+
+extern unsigned long count_island_runs;
+extern unsigned long count_island_branches;
+
 extern size_t size_opcodes;
 extern size_t size_vvp_nets;
 extern size_t size_vvp_net_funs;
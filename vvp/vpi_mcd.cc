@@ -55,6 +55,19 @@ static unsigned fd_table_len = 0;
 
 static FILE* logfile;
 
+/*
+ * Files opened by the simulation are given a stdio buffer much larger
+ * than the default. Testbenches that log heavily then make far fewer
+ * write system calls. The buffers are still flushed by $fflush and
+ * when the file is closed.
+ */
+static const size_t FILE_BUFFER_SIZE = 256 * 1024;
+
+static void set_file_buffer(FILE*fp)
+{
+      setvbuf(fp, NULL, _IOFBF, FILE_BUFFER_SIZE);
+}
+
 /* Initialize mcd portion of vpi.  Must be called before
  * any vpi_mcd routines can be used.
  */
@@ -164,6 +177,7 @@ got_entry:
 	mcd_table[i].fp = fopen(name, "w");
 	if(mcd_table[i].fp == NULL)
 		return 0;
+	set_file_buffer(mcd_table[i].fp);
 	mcd_table[i].filename = strdup(name);
 
 	if (vpi_trace) {
@@ -230,16 +244,20 @@ vpi_mcd_vprintf(PLI_UINT32 mcd, const char*fmt, va_list ap)
 #endif
       va_end(saved_ap);
 
-      for(int i = 0; i < 31; i++) {
-	    if((mcd>>i) & 1) {
-		  if(mcd_table[i].fp) {
-			  // echo to logfile
-			if (i == 0 && logfile)
-			      fputs(buf_ptr, logfile);
-			fputs(buf_ptr, mcd_table[i].fp);
-		  } else {
-			rc = EOF;
-		  }
+	/* The text is formatted once above, and its length is known,
+	   so write it to each selected channel without rescanning it.
+	   Only the channels that are set in the mcd are visited. */
+      size_t len = rc;
+      for (int i = 0; mcd != 0; i += 1, mcd >>= 1) {
+	    if ((mcd & 1) == 0)
+		  continue;
+	    if (mcd_table[i].fp) {
+		    // echo to logfile
+		  if (i == 0 && logfile)
+			fwrite(buf_ptr, 1, len, logfile);
+		  fwrite(buf_ptr, 1, len, mcd_table[i].fp);
+	    } else {
+		  rc = EOF;
 	    }
       }
       if (need_free) free(buf_ptr);
@@ -308,6 +326,7 @@ extern "C" PLI_INT32 vpi_fopen(const char*name, const char*mode)
 got_entry:
       fd_table[i].fp = fopen(name, mode);
       if (fd_table[i].fp == NULL) return 0;
+      set_file_buffer(fd_table[i].fp);
       fd_table[i].filename = strdup(name);
       return ((1U<<31)|i);
 }
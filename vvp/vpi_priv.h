@@ -249,7 +249,7 @@ struct __vpiScope : public __vpiHandle {
         /* Keep a list of freed contexts. */
       vvp_context_t free_contexts;
 	/* Keep a list of threads in the scope. */
-      std::set<vthread_t> threads;
+      vthread_t threads;
       signed int time_units :8;
       signed int time_precision :8;
 
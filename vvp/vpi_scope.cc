@@ -468,6 +468,7 @@ compile_scope_decl(char*label, char*type, char*name, char*tname,
       scope->nitem = 0;
       scope->live_contexts = 0;
       scope->free_contexts = 0;
+      scope->threads = 0;
 
       if (is_cell) scope->is_cell = true;
       else scope->is_cell = false;
@@ -569,8 +570,8 @@ unsigned vpip_add_item_to_context(automatic_hooks_s*item,
 
       scope->item[idx] = item;
 
-        /* Offset the context index by 2 to leave space for the list links. */
-      return 2 + idx;
+        /* Offset the context index by 3 to leave space for the list links. */
+      return 3 + idx;
 }
 
 
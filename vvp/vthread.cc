@@ -31,7 +31,6 @@
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
-# include  <set>
 # include  <typeinfo>
 # include  <vector>
 # include  <cstdlib>
@@ -65,10 +64,15 @@ using namespace std;
  *
  * Children placed into a task or function scope are given special
  * treatment, which is required to make task/function calls that they
- * represent work correctly. These task/function children are copied
- * into a task_func_children set to mark them for this handling. %join
- * operations will guarantee that task/function threads are joined first,
- * before any non-task/function threads.
+ * represent work correctly. These task/function children are marked
+ * with the is_task_func_child flag and counted in the parent's
+ * task_func_children for this handling. %join operations will
+ * guarantee that task/function threads are joined first, before any
+ * non-task/function threads.
+ *
+ * The children of a thread, and the threads of a scope, are kept in
+ * doubly linked lists threaded through the vthread_s objects
+ * themselves, so that %fork, %join and %end do not need to allocate.
  *
  * It is a programming error for a thread that created threads to not
  * %join (or %join/detach) as many as it created before it %ends. The
@@ -202,14 +206,21 @@ struct vthread_s {
       unsigned waiting_for_event :1;
       unsigned is_scheduled      :1;
       unsigned delay_delete      :1;
-	/* This points to the children of the thread. */
-      set<struct vthread_s*>children;
+	/* My parent counts me in its task_func_children. */
+      unsigned is_task_func_child :1;
+	/* This points to the children of the thread, which are linked
+	   through their child_next/child_prev pointers. */
+      struct vthread_s*children;
+      struct vthread_s*child_next, *child_prev;
+      unsigned nchildren;
 	/* No more than 1 of the children are tasks or functions. */
-      set<vthread_s*>task_func_children;
+      unsigned task_func_children;
 	/* This points to my parent, if I have one. */
       struct vthread_s*parent;
-	/* This points to the containing scope. */
+	/* This points to the containing scope, and these link me into
+	   the list of threads in that scope. */
       struct __vpiScope*parent_scope;
+      struct vthread_s*scope_next, *scope_prev;
 	/* This is used for keeping wait queues. */
       struct vthread_s*wait_next;
 	/* These are used to access automatically allocated items. */
@@ -220,10 +231,17 @@ struct vthread_s {
 
       inline void cleanup()
       {
-	    bits4 = vvp_vector4_t();
+	      /* Keep the bits4 storage for the next thread that
+		 reuses this object, unless it grew very large. */
+	    if (bits4.size() > BITS4_KEEP_MAX)
+		  bits4 = vvp_vector4_t(32);
 	    assert(stack_real_.empty());
 	    assert(stack_str_.empty());
+	    assert(stack_obj_size_ == 0);
       }
+
+    private:
+      enum { BITS4_KEEP_MAX = 4096 };
 };
 
 inline vthread_s::vthread_s()
@@ -234,6 +252,67 @@ inline vthread_s::vthread_s()
 static bool test_joinable(vthread_t thr, vthread_t child);
 static void do_join(vthread_t thr, vthread_t child);
 
+static void thr_add_child(vthread_t thr, vthread_t child)
+{
+      assert(child->parent == 0);
+      child->parent = thr;
+      child->child_prev = 0;
+      child->child_next = thr->children;
+      if (thr->children)
+	    thr->children->child_prev = child;
+      thr->children = child;
+      thr->nchildren += 1;
+}
+
+static void thr_remove_child(vthread_t thr, vthread_t child)
+{
+      assert(child->parent == thr);
+
+      if (child->child_prev) {
+	    child->child_prev->child_next = child->child_next;
+      } else {
+	    assert(thr->children == child);
+	    thr->children = child->child_next;
+      }
+      if (child->child_next)
+	    child->child_next->child_prev = child->child_prev;
+
+      child->child_next = 0;
+      child->child_prev = 0;
+      child->parent = 0;
+
+      assert(thr->nchildren > 0);
+      thr->nchildren -= 1;
+
+      if (child->is_task_func_child) {
+	    assert(thr->task_func_children > 0);
+	    thr->task_func_children -= 1;
+	    child->is_task_func_child = 0;
+      }
+}
+
+/*
+ * Remove the thread from the list of threads in its scope. It is OK
+ * to call this for a thread that has already been removed.
+ */
+static void thr_scope_remove(vthread_t thr)
+{
+      struct __vpiScope*scope = thr->parent_scope;
+
+      if (thr->scope_prev)
+	    thr->scope_prev->scope_next = thr->scope_next;
+      else if (scope->threads == thr)
+	    scope->threads = thr->scope_next;
+      else
+	    return;
+
+      if (thr->scope_next)
+	    thr->scope_next->scope_prev = thr->scope_prev;
+
+      thr->scope_next = 0;
+      thr->scope_prev = 0;
+}
+
 struct __vpiScope* vthread_scope(struct vthread_s*thr)
 {
       return thr->parent_scope;
@@ -241,6 +320,13 @@ struct __vpiScope* vthread_scope(struct vthread_s*thr)
 
 struct vthread_s*running_thread = 0;
 
+/*
+ * Threads are created and deleted very often, so deleted thread
+ * objects are kept on this list (linked through wait_next) and reused
+ * by vthread_new, along with the storage of their bits4 vector.
+ */
+static vthread_t vthread_free_list = 0;
+
 // this table maps the thread special index bit addresses to
 // vvp_bit4_t bit values.
 static vvp_bit4_t thr_index_to_bit4[4] = { BIT4_0, BIT4_1, BIT4_X, BIT4_Z };
@@ -319,19 +405,22 @@ template <class T> T coerce_to_width(const T&that, unsigned width)
       return res;
 }
 
-static unsigned long* vector_to_array(struct vthread_s*thr,
-				      unsigned addr, unsigned wid)
+/*
+ * Get the 2-state bits of a thread vector into the caller's array of
+ * words, which must have room for wid bits. Return false if any of
+ * the bits are X or Z.
+ */
+static bool vector_to_words(struct vthread_s*thr, unsigned addr,
+			    unsigned wid, unsigned long*val)
 {
+      unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
+
       if (addr == 0) {
-	    unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
-	    unsigned long*val = new unsigned long[awid];
 	    for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
 		  val[idx] = 0;
-	    return val;
+	    return true;
       }
       if (addr == 1) {
-	    unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
-	    unsigned long*val = new unsigned long[awid];
 	    for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
 		  val[idx] = -1UL;
 
@@ -339,15 +428,60 @@ static unsigned long* vector_to_array(struct vthread_s*thr,
 	    if (wid < CPU_WORD_BITS)
 		  val[awid-1] &= (-1UL) >> (CPU_WORD_BITS-wid);
 
-	    return val;
+	    return true;
       }
 
       if (addr < 4)
-	    return 0;
+	    return false;
 
-      return thr->bits4.subarray(addr, wid);
+      return thr->bits4.subarray(val, addr, wid);
 }
 
+static unsigned long* vector_to_array(struct vthread_s*thr,
+				      unsigned addr, unsigned wid)
+{
+      unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
+      unsigned long*val = new unsigned long[awid];
+
+      if (vector_to_words(thr, addr, wid, val))
+	    return val;
+
+      delete[]val;
+      return 0;
+}
+
+/*
+ * Compare instructions run very often, so get their operands into
+ * this buffer instead of allocating with vector_to_array. Vectors up
+ * to a few words wide fit in the local storage.
+ */
+class thr_words_t {
+    public:
+      explicit thr_words_t(unsigned wid)
+      {
+	    unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
+	    if (awid <= sizeof local_ / sizeof local_[0])
+		  ptr = local_;
+	    else
+		  ptr = new unsigned long[awid];
+      }
+
+      ~thr_words_t()
+      {
+	    if (ptr != local_)
+		  delete[]ptr;
+      }
+
+      unsigned long*ptr;
+
+    private:
+      unsigned long local_[4];
+
+    private: // not implemented
+      thr_words_t(const thr_words_t&);
+      thr_words_t& operator= (const thr_words_t&);
+};
+
 /*
  * This function gets from the thread a vector of bits starting from
  * the addressed location and for the specified width.
@@ -468,6 +602,9 @@ static vvp_context_t vthread_alloc_context(struct __vpiScope*scope)
       }
 
       vvp_set_next_context(context, scope->live_contexts);
+      vvp_set_prev_context(context, 0);
+      if (scope->live_contexts)
+            vvp_set_prev_context(scope->live_contexts, context);
       scope->live_contexts = context;
 
       return context;
@@ -476,23 +613,25 @@ static vvp_context_t vthread_alloc_context(struct __vpiScope*scope)
 /*
  * Free a context previously allocated to a child thread by pushing it
  * onto the freed context stack. Remove it from the list of live contexts
- * in that scope.
+ * in that scope. The live list is doubly linked so this does not depend
+ * on how many contexts are live.
  */
 static void vthread_free_context(vvp_context_t context, struct __vpiScope*scope)
 {
       assert(scope->is_automatic);
       assert(context);
 
-      if (context == scope->live_contexts) {
-            scope->live_contexts = vvp_get_next_context(context);
+      vvp_context_t next = vvp_get_next_context(context);
+      vvp_context_t prev = vvp_get_prev_context(context);
+
+      if (prev) {
+            vvp_set_next_context(prev, next);
       } else {
-            vvp_context_t tmp = scope->live_contexts;
-            while (context != vvp_get_next_context(tmp)) {
-                  assert(tmp);
-                  tmp = vvp_get_next_context(tmp);
-            }
-            vvp_set_next_context(tmp, vvp_get_next_context(context));
+            assert(context == scope->live_contexts);
+            scope->live_contexts = next;
       }
+      if (next)
+            vvp_set_prev_context(next, prev);
 
       vvp_set_next_context(context, scope->free_contexts);
       scope->free_contexts = context;
@@ -520,9 +659,21 @@ void contexts_delete(struct __vpiScope*scope)
  */
 vthread_t vthread_new(vvp_code_t pc, struct __vpiScope*scope)
 {
-      vthread_t thr = new struct vthread_s;
+      vthread_t thr = vthread_free_list;
+      if (thr) {
+	    vthread_free_list = thr->wait_next;
+	    thr->bits4.set_to_x();
+      } else {
+	    thr = new struct vthread_s;
+	    thr->bits4 = vvp_vector4_t(32);
+      }
+
       thr->pc     = pc;
-      thr->bits4  = vvp_vector4_t(32);
+      thr->children = 0;
+      thr->child_next = 0;
+      thr->child_prev = 0;
+      thr->nchildren = 0;
+      thr->task_func_children = 0;
       thr->parent = 0;
       thr->parent_scope = scope;
       thr->wait_next = 0;
@@ -534,6 +685,7 @@ vthread_t vthread_new(vvp_code_t pc, struct __vpiScope*scope)
       thr->i_have_ended = 0;
       thr->delay_delete = 0;
       thr->waiting_for_event = 0;
+      thr->is_task_func_child = 0;
       thr->event  = 0;
       thr->ecount = 0;
 
@@ -542,7 +694,11 @@ vthread_t vthread_new(vvp_code_t pc, struct __vpiScope*scope)
       thr_put_bit(thr, 2, BIT4_X);
       thr_put_bit(thr, 3, BIT4_Z);
 
-      scope->threads .insert(thr);
+      thr->scope_prev = 0;
+      thr->scope_next = scope->threads;
+      if (scope->threads)
+	    scope->threads->scope_prev = thr;
+      scope->threads = thr;
       return thr;
 }
 
@@ -576,11 +732,20 @@ static void child_delete(vthread_t base)
 
 void vthreads_delete(struct __vpiScope*scope)
 {
-      for (std::set<vthread_t>::iterator cur = scope->threads.begin()
-		 ; cur != scope->threads.end() ; ++ cur ) {
-	    delete *cur;
+      while (scope->threads) {
+	    vthread_t cur = scope->threads;
+	    scope->threads = cur->scope_next;
+	    delete cur;
+      }
+}
+
+void vthread_pool_delete()
+{
+      while (vthread_free_list) {
+	    vthread_t cur = vthread_free_list;
+	    vthread_free_list = cur->wait_next;
+	    delete cur;
       }
-      scope->threads.clear();
 }
 #endif
 
@@ -590,23 +755,17 @@ void vthreads_delete(struct __vpiScope*scope)
  */
 static void vthread_reap(vthread_t thr)
 {
-      if (! thr->children.empty()) {
-	    for (set<vthread_t>::iterator cur = thr->children.begin()
-		       ; cur != thr->children.end() ; ++cur) {
-		  vthread_t curp = *cur;
-		  assert(curp->parent == thr);
-		  curp->parent = thr->parent;
-	    }
-      }
-      if (thr->parent) {
-	      //assert(thr->parent->child == thr);
-	    thr->parent->children.erase(thr);
+      while (thr->children) {
+	    vthread_t curp = thr->children;
+	    thr_remove_child(thr, curp);
+	    if (thr->parent)
+		  thr_add_child(thr->parent, curp);
       }
-
-      thr->parent = 0;
+      if (thr->parent)
+	    thr_remove_child(thr->parent, thr);
 
 	// Remove myself from the containing scope.
-      thr->parent_scope->threads.erase(thr);
+      thr_scope_remove(thr);
 
       thr->pc = codespace_null();
 
@@ -614,7 +773,7 @@ static void vthread_reap(vthread_t thr)
 	   it now. Otherwise, let the schedule event (which will
 	   execute the thread at of_ZOMBIE) delete the object. */
       if ((thr->is_scheduled == 0) && (thr->waiting_for_event == 0)) {
-	    assert(thr->children.empty());
+	    assert(thr->children == 0);
 	    assert(thr->wait_next == 0);
 	    if (thr->delay_delete)
 		  schedule_del_thr(thr);
@@ -626,7 +785,8 @@ static void vthread_reap(vthread_t thr)
 void vthread_delete(vthread_t thr)
 {
       thr->cleanup();
-      delete thr;
+      thr->wait_next = vthread_free_list;
+      vthread_free_list = thr;
 }
 
 void vthread_mark_scheduled(vthread_t thr)
@@ -691,16 +851,21 @@ bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code)
 /*
  * This is called by an event functor to wake up all the threads on
  * its list. I in fact created that list in the %wait instruction, and
- * I also am certain that the waiting_for_event flag is set.
+ * I also am certain that the waiting_for_event flag is set. Clocks
+ * can have very many waiting threads, so clear the waiting flag and
+ * mark the thread scheduled in the same pass over the list, and let
+ * a single event run them all.
  */
 void vthread_schedule_list(vthread_t thr)
 {
       for (vthread_t cur = thr ;  cur ;  cur = cur->wait_next) {
 	    assert(cur->waiting_for_event);
+	    assert(cur->is_scheduled == 0);
 	    cur->waiting_for_event = 0;
+	    cur->is_scheduled = 1;
       }
 
-      schedule_vthread(thr, 0);
+      schedule_vthread_list(thr);
 }
 
 vvp_context_t vthread_get_wt_context()
@@ -1532,7 +1697,7 @@ bool of_CAST2(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
-bool of_CMPS(vthread_t thr, vvp_code_t cp)
+static bool of_CMPS_the_hard_way(vthread_t thr, vvp_code_t cp)
 {
       vvp_bit4_t eq  = BIT4_1;
       vvp_bit4_t eeq = BIT4_1;
@@ -1603,6 +1768,51 @@ bool of_CMPS(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+bool of_CMPS(vthread_t thr, vvp_code_t cp)
+{
+      unsigned idx1 = cp->bit_idx[0];
+      unsigned idx2 = cp->bit_idx[1];
+      unsigned wid  = cp->number;
+
+      if (idx1 >= 4) thr_check_addr(thr, idx1+wid-1);
+      if (idx2 >= 4) thr_check_addr(thr, idx2+wid-1);
+
+      if (wid == 0)
+	    return of_CMPS_the_hard_way(thr, cp);
+
+      thr_words_t lval (wid);
+      thr_words_t rval (wid);
+      if (! vector_to_words(thr, idx1, wid, lval.ptr))
+	    return of_CMPS_the_hard_way(thr, cp);
+      if (! vector_to_words(thr, idx2, wid, rval.ptr))
+	    return of_CMPS_the_hard_way(thr, cp);
+
+      unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
+
+	/* Flip the sign bits so that an unsigned compare of the words
+	   gives the signed result. */
+      unsigned long sign = 1UL << ((wid-1) % CPU_WORD_BITS);
+      lval.ptr[words-1] ^= sign;
+      rval.ptr[words-1] ^= sign;
+
+      vvp_bit4_t eq = BIT4_1;
+      vvp_bit4_t lt = BIT4_0;
+      for (unsigned wdx = words ; wdx > 0 ; wdx -= 1) {
+	    if (lval.ptr[wdx-1] == rval.ptr[wdx-1])
+		  continue;
+
+	    eq = BIT4_0;
+	    lt = (lval.ptr[wdx-1] < rval.ptr[wdx-1])? BIT4_1 : BIT4_0;
+	    break;
+      }
+
+      thr_put_bit(thr, 4, eq);
+      thr_put_bit(thr, 5, lt);
+      thr_put_bit(thr, 6, eq);
+
+      return true;
+}
+
 bool of_CMPSTR(vthread_t thr, vvp_code_t)
 {
       string re = thr->pop_str();
@@ -1728,28 +1938,26 @@ bool of_CMPIU(vthread_t thr, vvp_code_t cp)
       unsigned long imm  = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*array = vector_to_array(thr, addr, wid);
+      thr_words_t array (wid);
 	// If there are xz bits in the right hand expression, then we
 	// have to do the compare the hard way. That is because even
 	// though we know that eeq must be false (the immediate value
 	// cannot have x or z bits) we don't know what the EQ or LT
 	// bits will be.
-      if (array == 0)
+      if (! vector_to_words(thr, addr, wid, array.ptr))
 	    return of_CMPIU_the_hard_way(thr, cp);
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
       vvp_bit4_t eq  = BIT4_1;
       vvp_bit4_t lt  = BIT4_0;
       for (unsigned idx = 0 ; idx < words ; idx += 1, imm = 0UL) {
-	    if (array[idx] == imm)
+	    if (array.ptr[idx] == imm)
 		  continue;
 
 	    eq = BIT4_0;
-	    lt = (array[idx] < imm) ? BIT4_1 : BIT4_0;
+	    lt = (array.ptr[idx] < imm) ? BIT4_1 : BIT4_0;
       }
 
-      delete[]array;
-
       thr_put_bit(thr, 4, eq);
       thr_put_bit(thr, 5, lt);
       thr_put_bit(thr, 6, eq);
@@ -1802,31 +2010,27 @@ bool of_CMPU(vthread_t thr, vvp_code_t cp)
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*larray = vector_to_array(thr, idx1, wid);
-      if (larray == 0) return of_CMPU_the_hard_way(thr, cp);
+      thr_words_t larray (wid);
+      if (! vector_to_words(thr, idx1, wid, larray.ptr))
+	    return of_CMPU_the_hard_way(thr, cp);
 
-      unsigned long*rarray = vector_to_array(thr, idx2, wid);
-      if (rarray == 0) {
-	    delete[]larray;
+      thr_words_t rarray (wid);
+      if (! vector_to_words(thr, idx2, wid, rarray.ptr))
 	    return of_CMPU_the_hard_way(thr, cp);
-      }
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
 
       for (unsigned wdx = 0 ; wdx < words ; wdx += 1) {
-	    if (larray[wdx] == rarray[wdx])
+	    if (larray.ptr[wdx] == rarray.ptr[wdx])
 		  continue;
 
 	    eq = BIT4_0;
-	    if (larray[wdx] < rarray[wdx])
+	    if (larray.ptr[wdx] < rarray.ptr[wdx])
 		  lt = BIT4_1;
 	    else
 		  lt = BIT4_0;
       }
 
-      delete[]larray;
-      delete[]rarray;
-
       thr_put_bit(thr, 4, eq);
       thr_put_bit(thr, 5, lt);
       thr_put_bit(thr, 6, eq);
@@ -2140,7 +2344,7 @@ static bool do_disable(vthread_t thr, vthread_t match)
       bool flag = false;
 
 	/* Pull the target thread out of its scope. */
-      thr->parent_scope->threads.erase(thr);
+      thr_scope_remove(thr);
 
 	/* Turn the thread off by setting is program counter to
 	   zero and setting an OFF bit. */
@@ -2150,9 +2354,9 @@ static bool do_disable(vthread_t thr, vthread_t match)
 	/* Turn off all the children of the thread. Simulate a %join
 	   for as many times as needed to clear the results of all the
 	   %forks that this thread has done. */
-      while (!thr->children.empty()) {
+      while (thr->children) {
 
-	    vthread_t tmp = *(thr->children.begin());
+	    vthread_t tmp = thr->children;
 	    assert(tmp);
 	    assert(tmp->parent == thr);
 	    thr->i_am_joining = 0;
@@ -2200,15 +2404,15 @@ bool of_DISABLE(vthread_t thr, vvp_code_t cp)
 
       bool disabled_myself_flag = false;
 
-      while (! scope->threads.empty()) {
-	    set<vthread_t>::iterator cur = scope->threads.begin();
+      while (scope->threads) {
+	    vthread_t cur = scope->threads;
 
 	      /* If I am disabling myself, then remember that fact so
 		 that I can finish this statement differently. */
-	    if (*cur == thr)
+	    if (cur == thr)
 		  disabled_myself_flag = true;
 
-	    if (do_disable(*cur, thr))
+	    if (do_disable(cur, thr))
 		  disabled_myself_flag = true;
       }
 
@@ -2216,130 +2420,20 @@ bool of_DISABLE(vthread_t thr, vvp_code_t cp)
 }
 
 /*
- * This function divides a 2-word number {high, a} by a 1-word
- * number. Assume that high < b.
+ * Divide ap by bp, where both are wid bits. Return a new array with
+ * the quotient, and leave the remainder in ap. Return nil if bp is
+ * zero.
  */
-static unsigned long divide2words(unsigned long a, unsigned long b,
-				  unsigned long high)
-{
-      unsigned long result = 0;
-      while (high > 0) {
-	    unsigned long tmp_result = ULONG_MAX / b;
-	    unsigned long remain = ULONG_MAX % b;
-
-	    remain += 1;
-	    if (remain >= b) {
-		  remain -= b;
-		  tmp_result += 1;
-	    }
-
-	      // Now 0x1_0...0 = b*tmp_result + remain
-	      // high*0x1_0...0 = high*(b*tmp_result + remain)
-	      // high*0x1_0...0 = high*b*tmp_result + high*remain
-
-	      // We know that high*0x1_0...0 >= high*b*tmp_result, and
-	      // we know that high*0x1_0...0 > high*remain. Use
-	      // high*remain as the remainder for another iteration,
-	      // and add tmp_result*high into the current estimate of
-	      // the result.
-	    result += tmp_result * high;
-
-	      // The new iteration starts with high*remain + a.
-	    remain = multiply_with_carry(high, remain, high);
-	    a += remain;
-            if(a < remain)
-              high += 1;
-
-	      // Now result*b + {high,a} == the input {high,a}. It is
-	      // possible that the new high >= 1. If so, it will
-	      // certainly be less than high from the previous
-	      // iteration. Do another iteration and it will shrink,
-	      // eventually to 0.
-      }
-
-	// high is now 0, so a is the remaining remainder, so we can
-	// finish off the integer divide with a simple a/b.
-
-      return result + a/b;
-}
-
 static unsigned long* divide_bits(unsigned long*ap, unsigned long*bp, unsigned wid)
 {
-	// Do all our work a cpu-word at a time. The "words" variable
-	// is the number of words of the wid.
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
 
-      unsigned btop = words-1;
-      while (btop > 0 && bp[btop] == 0)
-	    btop -= 1;
-
-	// Detect divide by 0, and exit.
-      if (btop==0 && bp[0]==0)
+      unsigned long*result = new unsigned long[words];
+      if (! vvp_divmod_words(result, ap, ap, bp, words)) {
+	    delete[]result;
 	    return 0;
-
-	// The result array will eventually accumulate the result. The
-	// diff array is a difference that we use in the intermediate.
-      unsigned long*diff  = new unsigned long[words];
-      unsigned long*result= new unsigned long[words];
-      for (unsigned idx = 0 ; idx < words ; idx += 1)
-	    result[idx] = 0;
-
-      for (unsigned cur = words-btop ; cur > 0 ; cur -= 1) {
-	    unsigned cur_ptr = cur-1;
-	    unsigned long cur_res;
-	    if (ap[cur_ptr+btop] >= bp[btop]) {
-		  unsigned long high = 0;
-		  if (cur_ptr+btop+1 < words)
-			high = ap[cur_ptr+btop+1];
-		  cur_res = divide2words(ap[cur_ptr+btop], bp[btop], high);
-
-	    } else if (cur_ptr+btop+1 >= words) {
-		  continue;
-
-	    } else if (ap[cur_ptr+btop+1] == 0) {
-		  continue;
-
-	    } else {
-		  cur_res = divide2words(ap[cur_ptr+btop], bp[btop],
-					 ap[cur_ptr+btop+1]);
-	    }
-
-	      // cur_res is a guesstimate of the result this far. It
-	      // may be 1 too big. (But it will also be >0) Try it,
-	      // and if the difference comes out negative, then adjust.
-
-	      // diff = (bp * cur_res)  << cur_ptr;
-	    multiply_array_imm(diff+cur_ptr, bp, words-cur_ptr, cur_res);
-	      // ap -= diff
-	    unsigned long carry = 1;
-	    for (unsigned idx = cur_ptr ; idx < words ; idx += 1)
-		  ap[idx] = add_with_carry(ap[idx], ~diff[idx], carry);
-
-	      // ap has the diff subtracted out of it. If cur_res was
-	      // too large, then ap will turn negative. (We easily
-	      // tell that ap turned negative by looking at
-	      // carry&1. If it is 0, then it is *negative*.) In that
-	      // case, we know that cur_res was too large by 1. Correct by
-	      // adding 1b back in and reducing cur_res.
-	    if ((carry&1) == 0) {
-		    // Keep adding b back in until the remainder
-		    // becomes positive again.
-		  do {
-			cur_res -= 1;
-			carry = 0;
-			for (unsigned idx = cur_ptr ; idx < words ; idx += 1)
-			      ap[idx] = add_with_carry(ap[idx], bp[idx-cur_ptr], carry);
-		  } while (carry == 0);
-	    }
-
-	    result[cur_ptr] = cur_res;
       }
 
-	// Now ap contains the remainder and result contains the
-	// desired result. We should find that:
-	//  input-a = bp * result + ap;
-
-      delete[]diff;
       return result;
 }
 
@@ -2549,7 +2643,7 @@ bool of_END(vthread_t thr, vvp_code_t)
 	   main thread (there is no other parent) and an error (not
 	   enough %joins) has been detected. */
       if (thr->parent == 0) {
-	    assert(thr->children.empty());
+	    assert(thr->children == 0);
 	    vthread_reap(thr);
 	    return false;
       }
@@ -2712,20 +2806,21 @@ bool of_FORK(vthread_t thr, vvp_code_t cp)
             child->rd_context = thr->wt_context;
       }
 
-      child->parent = thr;
-      thr->children.insert(child);
+      thr_add_child(thr, child);
 
 	/* If the child scope is not the same as the current scope,
 	   infer that this is a task or function call. */
       switch (cp->scope->get_type_code()) {
 	  case vpiFunction:
-	    thr->task_func_children.insert(child);
+	    child->is_task_func_child = 1;
+	    thr->task_func_children += 1;
 	    child->is_scheduled = 1;
 	    vthread_run(child);
 	    running_thread = thr;
 	    break;
 	  case vpiTask:
-	    thr->task_func_children.insert(child);
+	    child->is_task_func_child = 1;
+	    thr->task_func_children += 1;
 	    schedule_vthread(child, 0, true);
 	    break;
 	  default:
@@ -3044,8 +3139,7 @@ bool of_JMP1(vthread_t thr, vvp_code_t cp)
 
 static bool test_joinable(vthread_t thr, vthread_t child)
 {
-      set<vthread_t>::iterator cur = thr->task_func_children.find(child);
-      if (!thr->task_func_children.empty() && cur == thr->task_func_children.end())
+      if (thr->task_func_children > 0 && !child->is_task_func_child)
 	    return false;
 
       return true;
@@ -3055,8 +3149,6 @@ static void do_join(vthread_t thr, vthread_t child)
 {
       assert(child->parent == thr);
 
-      thr->task_func_children.erase(child);
-
         /* If the immediate child thread is in an automatic scope... */
       if (child->wt_context) {
               /* and is the top level task/function thread... */
@@ -3077,13 +3169,11 @@ static void do_join(vthread_t thr, vthread_t child)
 bool of_JOIN(vthread_t thr, vvp_code_t)
 {
       assert( !thr->i_am_joining );
-      assert( !thr->children.empty());
+      assert( thr->children != 0);
 
 	// Are there any children that have already ended? If so, then
 	// join with that one.
-      for (set<vthread_t>::iterator cur = thr->children.begin()
-		 ; cur != thr->children.end() ; ++cur) {
-	    vthread_t curp = *cur;
+      for (vthread_t curp = thr->children ; curp ; curp = curp->child_next) {
 	    if (!curp->i_have_ended)
 		  continue;
 
@@ -3109,11 +3199,11 @@ bool of_JOIN_DETACH(vthread_t thr, vvp_code_t cp)
 {
       unsigned long count = cp->number;
 
-      assert(thr->task_func_children.empty());
-      assert(count == thr->children.size());
+      assert(thr->task_func_children == 0);
+      assert(count == thr->nchildren);
 
-      while (!thr->children.empty()) {
-	    vthread_t child = *thr->children.begin();
+      while (thr->children) {
+	    vthread_t child = thr->children;
 	    assert(child->parent == thr);
 
 	      // We cannot detach automatic tasks/functions within an
@@ -3126,8 +3216,7 @@ bool of_JOIN_DETACH(vthread_t thr, vvp_code_t cp)
 		  vthread_reap(child);
 
 	    } else {
-		  thr->children.erase(child);
-		  child->parent = 0;
+		  thr_remove_child(thr, child);
 	    }
       }
 
@@ -3592,129 +3681,62 @@ bool of_LOAD_X1P(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * The %mod and %mod/s instructions use this for values too wide for a
+ * native long long. The remainder takes the sign of the dividend.
+ */
 static void do_verylong_mod(vthread_t thr, vvp_code_t cp,
 			    bool left_is_neg, bool right_is_neg)
 {
-      bool out_is_neg = left_is_neg;
-      int len=cp->number;
-      unsigned char *a, *z, *t;
-      a = new unsigned char[len+1];
-      z = new unsigned char[len+1];
-      t = new unsigned char[len+1];
-
-      unsigned char carry;
-      unsigned char temp;
-
-      int mxa = -1, mxz = -1;
-      int i;
-      int current, copylen;
-
-      unsigned idx1 = cp->bit_idx[0];
-      unsigned idx2 = cp->bit_idx[1];
-
-      unsigned lb_carry = left_is_neg? 1 : 0;
-      unsigned rb_carry = right_is_neg? 1 : 0;
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-	    unsigned lb = thr_get_bit(thr, idx1);
-	    unsigned rb = thr_get_bit(thr, idx2);
-
-	    if ((lb | rb) & 2) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
-		  goto x_out;
-	    }
-
-	    if (left_is_neg) {
-		  lb = (1-lb) + lb_carry;
-		  lb_carry = (lb & ~1)? 1 : 0;
-		  lb &= 1;
-	    }
-	    if (right_is_neg) {
-		  rb = (1-rb) + rb_carry;
-		  rb_carry = (rb & ~1)? 1 : 0;
-		  rb &= 1;
-	    }
-
-	    z[idx]=lb;
-	    a[idx]=1-rb;	// for 2s complement add..
-
-	    idx1 += 1;
-	    if (idx2 >= 4)
-		  idx2 += 1;
-      }
-
-      z[len]=0;
-      a[len]=1;
+      unsigned adra = cp->bit_idx[0];
+      unsigned adrb = cp->bit_idx[1];
+      unsigned wid = cp->number;
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
 
-      for(i=len-1;i>=0;i--) {
-	    if(!a[i]) {
-		  mxa=i;
-		  break;
-	    }
+      unsigned long*ap = vector_to_array(thr, adra, wid);
+      if (ap == 0) {
+	    vvp_vector4_t tmp(wid, BIT4_X);
+	    thr->bits4.set_vec(adra, tmp);
+	    return;
       }
 
-      for(i=len-1;i>=0;i--) {
-	    if(z[i]) {
-		  mxz=i;
-		  break;
-	    }
+      unsigned long*bp = vector_to_array(thr, adrb, wid);
+      if (bp == 0) {
+	    delete[]ap;
+	    vvp_vector4_t tmp(wid, BIT4_X);
+	    thr->bits4.set_vec(adra, tmp);
+	    return;
       }
 
-      if((mxa>mxz)||(mxa==-1)) {
-	    if(mxa==-1) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
-		  goto x_out;
-	    }
-
-	    goto tally;
+	// Sign extend the negative values to fill out the array, then
+	// take the magnitudes.
+      unsigned long sign_mask = 0;
+      if (unsigned long sign_bits = (words*CPU_WORD_BITS) - wid)
+	    sign_mask = -1UL << (CPU_WORD_BITS-sign_bits);
+      if (left_is_neg) {
+	    ap[words-1] |= sign_mask;
+	    negate_words(ap, words);
       }
-
-      copylen = mxa + 2;
-      current = mxz - mxa;
-
-      while(current > -1) {
-	    carry = 1;
-	    for(i=0;i<copylen;i++) {
-		  temp = z[i+current] + a[i] + carry;
-		  t[i] = (temp&1);
-		  carry = (temp>>1);
-	    }
-
-	    if(carry) {
-		  for(i=0;i<copylen;i++) {
-			z[i+current] = t[i];
-		  }
-	    }
-
-	    current--;
+      if (right_is_neg) {
+	    bp[words-1] |= sign_mask;
+	    negate_words(bp, words);
       }
 
- tally:
-
-      carry = out_is_neg? 1 : 0;
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1) {
-	    unsigned ob = z[idx];
-	    if (out_is_neg) {
-		  ob = (1-ob) + carry;
-		  carry = (ob & ~1)? 1 : 0;
-		  ob = ob & 1;
-	    }
-	    thr_put_bit(thr, cp->bit_idx[0]+idx, ob?BIT4_1:BIT4_0);
+      if (! vvp_divmod_words(0, ap, ap, bp, words)) {
+	    delete[]ap;
+	    delete[]bp;
+	    vvp_vector4_t tmp(wid, BIT4_X);
+	    thr->bits4.set_vec(adra, tmp);
+	    return;
       }
 
-      delete []t;
-      delete []z;
-      delete []a;
-      return;
-
- x_out:
-      for (unsigned idx = 0 ;  idx < cp->number ;  idx += 1)
-	    thr_put_bit(thr, cp->bit_idx[0]+idx, BIT4_X);
+      if (left_is_neg)
+	    negate_words(ap, words);
+      ap[words-1] &= ~sign_mask;
 
-      return;
+      thr->bits4.setarray(adra, wid, ap);
+      delete[]ap;
+      delete[]bp;
 }
 
 bool of_MAX_WR(vthread_t thr, vvp_code_t)
@@ -4005,22 +4027,7 @@ bool of_MUL(vthread_t thr, vvp_code_t cp)
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
       unsigned long*res = new unsigned long[words];
-      for (unsigned idx = 0 ; idx < words ; idx += 1)
-	    res[idx] = 0;
-
-      for (unsigned mul_a = 0 ; mul_a < words ; mul_a += 1) {
-	    for (unsigned mul_b = 0 ; mul_b < (words-mul_a) ; mul_b += 1) {
-		  unsigned long sum;
-		  unsigned long tmp = multiply_with_carry(ap[mul_a], bp[mul_b], sum);
-		  unsigned base = mul_a + mul_b;
-		  unsigned long carry = 0;
-		  res[base] = add_with_carry(res[base], tmp, carry);
-		  for (unsigned add_idx = base+1; add_idx < words; add_idx += 1) {
-			res[add_idx] = add_with_carry(res[add_idx], sum, carry);
-			sum = 0;
-		  }
-	    }
-      }
+      vvp_mul_words(res, words, ap, words, bp, words);
 
       thr->bits4.setarray(adra, wid, res);
       delete[]ap;
@@ -4158,6 +4165,9 @@ bool of_NEW_DARRAY(vthread_t thr, vvp_code_t cp)
 	    obj = new vvp_darray_real(size);
       } else if (strcmp(text,"S") == 0) {
 	    obj = new vvp_darray_string(size);
+      } else if (text[0] == 'v') {
+	    unsigned wid = strtoul(text+1, 0, 10);
+	    obj = new vvp_darray_vec4(size, wid);
       } else {
 	    obj = new vvp_darray (size);
       }
@@ -4466,16 +4476,9 @@ bool of_POW(vthread_t thr, vvp_code_t cp)
       xv2.trim();
       yv2.trim();
 
-      vvp_vector2_t result = pow(xv2, yv2);
-
-        /* If the result is too small zero pad it. */
-      if (result.size() < wid) {
-	    for (unsigned jdx = wid-1;  jdx >= result.size();  jdx -= 1)
-		  thr_put_bit(thr, cp->bit_idx[0]+jdx, BIT4_0);
-	    wid = result.size();
-      }
+      vvp_vector2_t result = pow(xv2, yv2, wid);
 
-        /* Copy only what we need of the result. */
+        /* Copy the result, which is exactly wid bits. */
       for (unsigned jdx = 0;  jdx < wid;  jdx += 1)
 	    thr_put_bit(thr, cp->bit_idx[0]+jdx,
 	                result.value(jdx) ? BIT4_1 : BIT4_0);
@@ -5532,7 +5535,7 @@ bool of_XOR(vthread_t thr, vvp_code_t cp)
 bool of_ZOMBIE(vthread_t thr, vvp_code_t)
 {
       thr->pc = codespace_null();
-      if ((thr->parent == 0) && (thr->children.empty())) {
+      if ((thr->parent == 0) && (thr->children == 0)) {
 	    if (thr->delay_delete)
 		  schedule_del_thr(thr);
 	    else
@@ -5553,7 +5556,7 @@ bool of_EXEC_UFUNC(vthread_t thr, vvp_code_t cp)
       struct __vpiScope*child_scope = cp->ufunc_core_ptr->func_scope();
       assert(child_scope);
 
-      assert(thr->children.empty());
+      assert(thr->children == 0);
 
         /* We can take a number of shortcuts because we know that a
            continuous assignment can only occur in a static scope. */
@@ -62,6 +62,7 @@ extern void thread_word_delete(class __vpiHandle *item);
 extern void vpi_call_delete(class __vpiHandle *item);
 extern void exec_ufunc_delete(vvp_code_t euf_code);
 extern void vthreads_delete(struct __vpiScope*scope);
+extern void vthread_pool_delete();
 extern void vvp_net_delete(vvp_net_t *item);
 
 
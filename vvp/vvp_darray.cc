@@ -96,6 +96,37 @@ template class vvp_darray_atom<int16_t>;
 template class vvp_darray_atom<int32_t>;
 template class vvp_darray_atom<int64_t>;
 
+vvp_darray_vec4::vvp_darray_vec4(size_t siz, unsigned word_wid)
+: vvp_darray(siz), array_(new vvp_vector4array_sa(word_wid, siz))
+{
+}
+
+vvp_darray_vec4::~vvp_darray_vec4()
+{
+      delete array_;
+}
+
+void vvp_darray_vec4::set_word(unsigned adr, const vvp_vector4_t&value)
+{
+      if (adr >= array_->words())
+	    return;
+
+      if (value.size() == array_->width()) {
+	    array_->set_word(adr, value);
+	    return;
+      }
+
+      vvp_vector4_t tmp (value);
+      tmp.resize(array_->width());
+      array_->set_word(adr, tmp);
+}
+
+void vvp_darray_vec4::get_word(unsigned adr, vvp_vector4_t&value)
+{
+	// Out of range reads get X words from the array.
+      value = array_->get_word(adr);
+}
+
 vvp_darray_real::~vvp_darray_real()
 {
 }
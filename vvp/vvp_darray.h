@@ -24,6 +24,7 @@
 # include  <vector>
 
 class vvp_vector4_t;
+class vvp_vector4array_sa;
 
 class vvp_darray : public vvp_object {
 
@@ -59,6 +60,29 @@ template <class TYPE> class vvp_darray_atom : public vvp_darray {
       std::vector<TYPE> array_;
 };
 
+/*
+ * Dynamic arrays of 4-state vectors keep their words in the packed
+ * storage of a vvp_vector4array_sa instead of a vvp_vector4_t per
+ * element, so large arrays of wide words do not need a heap
+ * allocation for each element.
+ */
+class vvp_darray_vec4 : public vvp_darray {
+
+    public:
+      vvp_darray_vec4(size_t siz, unsigned word_wid);
+      ~vvp_darray_vec4();
+
+      void set_word(unsigned adr, const vvp_vector4_t&value);
+      void get_word(unsigned adr, vvp_vector4_t&value);
+
+    private:
+      vvp_vector4array_sa*array_;
+
+    private: // Not implemented
+      vvp_darray_vec4(const vvp_darray_vec4&);
+      vvp_darray_vec4& operator= (const vvp_darray_vec4&);
+};
+
 class vvp_darray_real : public vvp_darray {
 
     public:
@@ -25,6 +25,7 @@
 # include  "symbols.h"
 # include  "schedule.h"
 # include  <list>
+# include  <vector>
 # include  <cassert>
 
 /*
@@ -66,8 +67,9 @@ class vvp_island  : private vvp_gen_event_s {
 	// Ports call this method to flag that something happened at
 	// the input. The island will use this to create an active
 	// event. The run_run() method will then be called by the
-	// scheduler to process whatever happened.
-      void flag_island();
+	// scheduler to process whatever happened. The port is also
+	// added to the list of flagged ports.
+      void flag_island(vvp_island_port*port);
 
 	// This is the method that is called, eventually, to process
 	// whatever happened. The derived island class implements this
@@ -84,6 +86,11 @@ class vvp_island  : private vvp_gen_event_s {
 	// scanning the mesh.
       vvp_island_branch*branches_;
 
+	// These are the ports that have flagged the island since the
+	// derived class last cleared the list. The flagged member of
+	// each listed port is true, so each port is listed only once.
+      std::vector<vvp_island_port*> flagged_ports_;
+
     public: /* These methods are used during linking. */
 
 	// Add a port to the island. The key is added to the island
@@ -144,6 +151,12 @@ class vvp_island_port  : public vvp_net_fun_t {
       vvp_vector8_t invalue;
       vvp_vector8_t outvalue;
       vvp_vector8_t value;
+	// True while the port is in the flagged_ports_ list of its
+	// island.
+      bool flagged;
+	// The island uses this to mark ports while it scans the
+	// mesh.
+      unsigned long mark;
 
     private:
       vvp_island*island_;
@@ -33,6 +33,7 @@
 # include  <climits>
 # include  <cmath>
 # include  <cassert>
+# include  <vector>
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
 # include  <map>
@@ -55,6 +56,7 @@ static size_t vvp_net_alloc_remaining = 0;
 // For statistics, count the vvp_nets allocated and the bytes of alloc
 // chunks allocated.
 unsigned long count_vvp_nets = 0;
+unsigned long count_fanout_arrays = 0;
 size_t size_vvp_nets = 0;
 
 void* vvp_net_t::operator new (size_t size)
@@ -174,15 +176,64 @@ void vvp_net_t::operator delete(void*)
       assert(0);
 }
 
+bool vvp_net_t::fanout_ready_ = false;
+vvp_net_ptr_t vvp_net_t::fanout_chain_[1];
+
 vvp_net_t::vvp_net_t()
 {
       out_ = vvp_net_ptr_t(0,0);
+      fanout_ = 0;
       fun = 0;
       fil = 0;
 }
 
+void vvp_net_t::fanout_ready()
+{
+      fanout_ready_ = true;
+}
+
+/*
+ * Copy the fanout chain of the net into an array. This is only done
+ * once the compiler is done linking, because until then the fanout
+ * is still being built up.
+ */
+void vvp_net_t::make_fanout_()
+{
+      if (! fanout_ready_)
+	    return;
+
+      unsigned count = 0;
+      vvp_net_ptr_t cur = out_;
+      while (vvp_net_t*net = cur.ptr()) {
+	    count += 1;
+	    cur = net->port[cur.port()];
+      }
+
+	// A chain this short is as cheap to walk as an array.
+      if (count < 2) {
+	    fanout_ = fanout_chain_;
+	    return;
+      }
+
+      fanout_ = new vvp_net_ptr_t[count+1];
+      count_fanout_arrays += 1;
+
+      count = 0;
+      cur = out_;
+      while (vvp_net_t*net = cur.ptr()) {
+	    fanout_[count++] = cur;
+	    cur = net->port[cur.port()];
+      }
+      fanout_[count] = vvp_net_ptr_t(0,0);
+}
+
 void vvp_net_t::link(vvp_net_ptr_t port_to_link)
 {
+	// The fanout is changing, so stop using the fanout array. A
+	// send may be scanning the array, so it is not deleted.
+      if (fanout_)
+	    fanout_ = fanout_chain_;
+
       vvp_net_t*net = port_to_link.ptr();
       net->port[port_to_link.port()] = out_;
       out_ = port_to_link;
@@ -196,6 +247,9 @@ void vvp_net_t::link(vvp_net_ptr_t port_to_link)
  */
 void vvp_net_t::unlink(vvp_net_ptr_t dst_ptr)
 {
+      if (fanout_)
+	    fanout_ = fanout_chain_;
+
       vvp_net_t*net = dst_ptr.ptr();
       unsigned net_port = dst_ptr.port();
 
@@ -506,6 +560,7 @@ void vvp_send_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&val)
 {
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_vec8(ptr, val);
@@ -514,10 +569,36 @@ void vvp_send_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&val)
       }
 }
 
+void vvp_send_vec8_fanout(vvp_net_ptr_t*fan, const vvp_vector8_t&val)
+{
+      while (vvp_net_t*cur = fan->ptr()) {
+	    vvp_prefetch_net(fan[1].ptr());
+
+	    if (cur->fun)
+		  cur->fun->recv_vec8(*fan, val);
+
+	    fan += 1;
+      }
+}
+
+void vvp_send_real_fanout(vvp_net_ptr_t*fan, double val,
+			  vvp_context_t context)
+{
+      while (vvp_net_t*cur = fan->ptr()) {
+	    vvp_prefetch_net(fan[1].ptr());
+
+	    if (cur->fun)
+		  cur->fun->recv_real(*fan, val, context);
+
+	    fan += 1;
+      }
+}
+
 void vvp_send_real(vvp_net_ptr_t ptr, double val, vvp_context_t context)
 {
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_real(ptr, val, context);
@@ -530,6 +611,7 @@ void vvp_send_long(vvp_net_ptr_t ptr, long val)
 {
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_long(ptr, val);
@@ -543,6 +625,7 @@ void vvp_send_long_pv(vvp_net_ptr_t ptr, long val,
 {
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_long_pv(ptr, val, base, wid);
@@ -945,6 +1028,18 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
       unsigned awid = (wid + BIT2_PER_WORD - 1) / (BIT2_PER_WORD);
       unsigned long*val = new unsigned long[awid];
 
+      if (subarray(val, adr, wid))
+	    return val;
+
+      delete[]val;
+      return 0;
+}
+
+bool vvp_vector4_t::subarray(unsigned long*val, unsigned adr, unsigned wid) const
+{
+      const unsigned BIT2_PER_WORD = 8*sizeof(unsigned long);
+      unsigned awid = (wid + BIT2_PER_WORD - 1) / (BIT2_PER_WORD);
+
       for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
 	    val[idx] = 0;
 
@@ -960,7 +1055,7 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 		  atmp &= (1UL << wid) - 1;
 		  btmp &= (1UL << wid) - 1;
 	    }
-	    if (btmp) goto x_out;
+	    if (btmp) return false;
 
 	    val[0] = atmp;
 
@@ -987,7 +1082,7 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 			atmp &= (1UL << trans) - 1;
 			btmp &= (1UL << trans) - 1;
 		  }
-		  if (btmp) goto x_out;
+		  if (btmp) return false;
 
 		  val[val_ptr] |= atmp << val_off;
 		  adr += trans;
@@ -1000,11 +1095,7 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 	    }
       }
 
-      return val;
-
- x_out:
-      delete[]val;
-      return 0;
+      return true;
 }
 
 void vvp_vector4_t::setarray(unsigned adr, unsigned wid, const unsigned long*val)
@@ -1396,6 +1487,50 @@ bool vvp_vector4_t::eeq(const vvp_vector4_t&that) const
       return true;
 }
 
+/*
+ * Compare a part of this vector with that vector a word at a time,
+ * without building the subvalue. Part selects use this to tell if
+ * the bits they look at changed, so that a change elsewhere in a wide
+ * vector can be ignored cheaply.
+ */
+bool vvp_vector4_t::eeq_part(unsigned adr, const vvp_vector4_t&that) const
+{
+      assert((adr + that.size_) <= size_);
+
+      const unsigned long*abits = size_ > BITS_PER_WORD? abits_ptr_ : &abits_val_;
+      const unsigned long*bbits = size_ > BITS_PER_WORD? bbits_ptr_ : &bbits_val_;
+      const unsigned long*that_abits = that.size_ > BITS_PER_WORD? that.abits_ptr_ : &that.abits_val_;
+      const unsigned long*that_bbits = that.size_ > BITS_PER_WORD? that.bbits_ptr_ : &that.bbits_val_;
+
+      unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+      unsigned ptr = adr / BITS_PER_WORD;
+      unsigned off = adr % BITS_PER_WORD;
+
+      unsigned dst = 0;
+      for (unsigned trans = 0 ;  trans < that.size_ ;  trans += BITS_PER_WORD) {
+	    unsigned long abit = abits[ptr] >> off;
+	    unsigned long bbit = bbits[ptr] >> off;
+	    ptr += 1;
+	    if (off != 0 && ptr < words) {
+		  abit |= abits[ptr] << (BITS_PER_WORD-off);
+		  bbit |= bbits[ptr] << (BITS_PER_WORD-off);
+	    }
+
+	    unsigned long mask = -1UL;
+	    if ((that.size_ - trans) < BITS_PER_WORD)
+		  mask = (1UL << (that.size_ - trans)) - 1;
+
+	    if ((abit ^ that_abits[dst]) & mask)
+		  return false;
+	    if ((bbit ^ that_bbits[dst]) & mask)
+		  return false;
+
+	    dst += 1;
+      }
+
+      return true;
+}
+
 bool vvp_vector4_t::eq_xz(const vvp_vector4_t&that) const
 {
       if (size_ != that.size_)
@@ -1845,43 +1980,91 @@ vvp_vector4_t vvp_vector4array_t::get_word_(v4cell*cell) const
       return res;
 }
 
+/*
+ * Arrays that take no more than this many unsigned longs are kept in a
+ * single page. Larger arrays are split into pages of about this size.
+ */
+static const unsigned long VEC4ARRAY_PAGE_LONGS = 16*1024;
+
+unsigned long count_var_array_pages = 0;
+
 vvp_vector4array_sa::vvp_vector4array_sa(unsigned width__, unsigned words__)
 : vvp_vector4array_t(width__, words__)
 {
-      array_ = new v4cell[words_];
+      cnt_ = (width_ + vvp_vector4_t::BITS_PER_WORD-1)/vvp_vector4_t::BITS_PER_WORD;
+      if (cnt_ == 0) cnt_ = 1;
 
-      if (width_ <= vvp_vector4_t::BITS_PER_WORD) {
-	    for (unsigned idx = 0 ; idx < words_ ; idx += 1) {
-		  array_[idx].abits_val_ = vvp_vector4_t::WORD_X_ABITS;
-		  array_[idx].bbits_val_ = vvp_vector4_t::WORD_X_BBITS;
-	    }
+      unsigned long total = 2UL * cnt_ * words_;
+      if (total <= VEC4ARRAY_PAGE_LONGS) {
+	    page_shift_ = 0;
+	    while ((1UL << page_shift_) < words_)
+		  page_shift_ += 1;
+	    npages_ = 1;
       } else {
-	    for (unsigned idx = 0 ; idx < words_ ; idx += 1) {
-		  array_[idx].abits_ptr_ = 0;
-		  array_[idx].bbits_ptr_ = 0;
-	    }
+	    page_shift_ = 0;
+	    while ((2UL << page_shift_) * 2 * cnt_ <= VEC4ARRAY_PAGE_LONGS)
+		  page_shift_ += 1;
+	    npages_ = ((words_-1) >> page_shift_) + 1;
       }
+
+      pages_ = new unsigned long*[npages_];
+      for (unsigned idx = 0 ; idx < npages_ ; idx += 1)
+	    pages_[idx] = 0;
+
+      if (npages_ == 1 && words_ > 0)
+	    alloc_page_(0);
 }
 
 vvp_vector4array_sa::~vvp_vector4array_sa()
 {
-      if (array_) {
-	    if (width_ > vvp_vector4_t::BITS_PER_WORD) {
-		  for (unsigned idx = 0 ; idx < words_ ; idx += 1)
-			if (array_[idx].abits_ptr_)
-			      delete[]array_[idx].abits_ptr_;
-	    }
-	    delete[]array_;
-      }
+      for (unsigned idx = 0 ; idx < npages_ ; idx += 1)
+	    delete[]pages_[idx];
+      delete[]pages_;
+}
+
+unsigned long* vvp_vector4array_sa::alloc_page_(unsigned page)
+{
+      assert(pages_[page] == 0);
+
+	/* The last page only needs to be big enough for the words that
+	   are left. */
+      unsigned long page_words = 1UL << page_shift_;
+      unsigned long first = (unsigned long)page << page_shift_;
+      if (first + page_words > words_)
+	    page_words = words_ - first;
+
+      unsigned long longs = 2 * cnt_ * page_words;
+      unsigned long*ptr = new unsigned long[longs];
+      for (unsigned long idx = 0 ; idx < longs ; idx += 1)
+	    ptr[idx] = vvp_vector4_t::WORD_X_ABITS;
+
+      count_var_array_pages += 1;
+      pages_[page] = ptr;
+      return ptr;
 }
 
 void vvp_vector4array_sa::set_word(unsigned index, const vvp_vector4_t&that)
 {
       assert(index < words_);
+      assert(that.size_ == width_);
 
-      v4cell*cell = &array_[index];
+      unsigned page = index >> page_shift_;
+      unsigned long*ptr = pages_[page];
+      if (ptr == 0)
+	    ptr = alloc_page_(page);
 
-      set_word_(cell, that);
+      ptr += 2 * cnt_ * (index & ((1UL << page_shift_) - 1));
+
+      if (width_ <= vvp_vector4_t::BITS_PER_WORD) {
+	    ptr[0] = that.abits_val_;
+	    ptr[1] = that.bbits_val_;
+	    return;
+      }
+
+      for (unsigned idx = 0 ; idx < cnt_ ; idx += 1)
+	    ptr[idx] = that.abits_ptr_[idx];
+      for (unsigned idx = 0 ; idx < cnt_ ; idx += 1)
+	    ptr[cnt_+idx] = that.bbits_ptr_[idx];
 }
 
 vvp_vector4_t vvp_vector4array_sa::get_word(unsigned index) const
@@ -1889,11 +2072,27 @@ vvp_vector4_t vvp_vector4array_sa::get_word(unsigned index) const
       if (index >= words_)
 	    return vvp_vector4_t(width_, BIT4_X);
 
-      assert(index < words_);
+      const unsigned long*ptr = pages_[index >> page_shift_];
+      if (ptr == 0)
+	    return vvp_vector4_t(width_, BIT4_X);
 
-      v4cell*cell = &array_[index];
+      ptr += 2 * cnt_ * (index & ((1UL << page_shift_) - 1));
 
-      return get_word_(cell);
+      if (width_ <= vvp_vector4_t::BITS_PER_WORD) {
+	    vvp_vector4_t res;
+	    res.size_ = width_;
+	    res.abits_val_ = ptr[0];
+	    res.bbits_val_ = ptr[1];
+	    return res;
+      }
+
+      vvp_vector4_t res (width_, BIT4_X);
+      for (unsigned idx = 0 ; idx < cnt_ ; idx += 1)
+	    res.abits_ptr_[idx] = ptr[idx];
+      for (unsigned idx = 0 ; idx < cnt_ ; idx += 1)
+	    res.bbits_ptr_[idx] = ptr[cnt_+idx];
+
+      return res;
 }
 
 vvp_vector4array_aa::vvp_vector4array_aa(unsigned width__, unsigned words__)
@@ -2347,33 +2546,6 @@ bool vvp_vector2_t::is_zero() const
       return true;
 }
 
-/*
- * Basic idea from "Introduction to Programming using SML" by
- * Michael R. Hansen and Hans Rischel page 261 and "Seminumerical
- * Algorithms, Third Edition" by Donald E. Knuth section 4.6.3.
- */
-vvp_vector2_t pow(const vvp_vector2_t&x, vvp_vector2_t&y)
-{
-        /* If we have a zero exponent just return a 1 bit wide 1. */
-      if (y == vvp_vector2_t(0L, 1)) {
-	    return vvp_vector2_t(1L, 1);
-      }
-
-        /* Is the value odd? */
-      if (y.value(0) == 1) {
-	    y.set_bit(0, 0);  // A quick subtract by 1.
-	    vvp_vector2_t res = x * pow(x, y);
-	    res.trim();  // To keep the size under control trim extra zeros.
-	    return res;
-      }
-
-      y >>= 1;  // A fast divide by two. We know the LSB is zero.
-      vvp_vector2_t z = pow(x, y);
-      vvp_vector2_t res = z * z;
-      res.trim();  // To keep the size under control trim extra zeros.
-      return res;
-}
-
 static void multiply_long(unsigned long a, unsigned long b,
 			  unsigned long&low, unsigned long&high)
 {
@@ -2415,87 +2587,370 @@ static void multiply_long(unsigned long a, unsigned long b,
 }
 
 /*
- * Multiplication of two vector2 vectors returns a product as wide as
- * the sum of the widths of the input vectors.
+ * Multiply the a and b arrays the schoolbook way, and write the low
+ * rwords words of the product to res. Each row carries only as far
+ * as it needs to, instead of to the end of the result.
  */
-vvp_vector2_t operator * (const vvp_vector2_t&a, const vvp_vector2_t&b)
+static void mul_words_school(unsigned long*res, unsigned rwords,
+			     const unsigned long*a, unsigned awords,
+			     const unsigned long*b, unsigned bwords)
 {
-      const unsigned bits_per_word = 8 * sizeof(a.vec_[0]);
-      vvp_vector2_t r (0, a.size() + b.size());
-
-      unsigned awords = (a.wid_ + bits_per_word - 1) / bits_per_word;
-      unsigned bwords = (b.wid_ + bits_per_word - 1) / bits_per_word;
-      unsigned rwords = (r.wid_ + bits_per_word - 1) / bits_per_word;
+      for (unsigned idx = 0 ;  idx < rwords ;  idx += 1)
+	    res[idx] = 0;
 
-      for (unsigned bdx = 0 ;  bdx < bwords ;  bdx += 1) {
-	    unsigned long tmpb = b.vec_[bdx];
+      for (unsigned bdx = 0 ;  bdx < bwords && bdx < rwords ;  bdx += 1) {
+	    unsigned long tmpb = b[bdx];
 	    if (tmpb == 0)
 		  continue;
 
-	    for (unsigned adx = 0 ;  adx < awords ;  adx += 1) {
-		  unsigned long tmpa = a.vec_[adx];
-		  if (tmpa == 0)
-			continue;
-
+	    unsigned long carry = 0;
+	    unsigned adx;
+	    for (adx = 0 ;  adx < awords && adx+bdx < rwords ;  adx += 1) {
 		  unsigned long low, hig;
-		  multiply_long(tmpa, tmpb, low, hig);
-
-		  unsigned long carry = 0;
-		  for (unsigned sdx = 0
-			     ; (adx+bdx+sdx) < rwords
-			     ;  sdx += 1) {
+		  multiply_long(a[adx], tmpb, low, hig);
+		    // a*b + carry + res fits in two words, so these
+		    // carries never overflow hig.
+		  low += carry;
+		  if (low < carry)
+			hig += 1;
+		  res[adx+bdx] += low;
+		  if (res[adx+bdx] < low)
+			hig += 1;
+		  carry = hig;
+	    }
 
-			r.vec_[adx+bdx+sdx] = add_carry(r.vec_[adx+bdx+sdx],
-							low, carry);
-			low = hig;
-			hig = 0;
-		  }
+	    for (unsigned idx = adx+bdx ; carry && idx < rwords ; idx += 1) {
+		  res[idx] += carry;
+		  carry = res[idx] < carry? 1 : 0;
 	    }
       }
+}
 
+/*
+ * res = a + b, where awords >= bwords and res has awords words.
+ * Return the carry out of the top word.
+ */
+static unsigned long add_words(unsigned long*res,
+			       const unsigned long*a, unsigned awords,
+			       const unsigned long*b, unsigned bwords)
+{
+      unsigned long carry = 0;
+      for (unsigned idx = 0 ;  idx < awords ;  idx += 1)
+	    res[idx] = add_carry(a[idx], idx < bwords? b[idx] : 0, carry);
+      return carry;
+}
 
-      return r;
+/*
+ * res += val, where res has rwords words. Any words of val past the
+ * end of res must be zero.
+ */
+static void add_into_words(unsigned long*res, unsigned rwords,
+			   const unsigned long*val, unsigned vwords)
+{
+      unsigned long carry = 0;
+      for (unsigned idx = 0 ;  idx < rwords ;  idx += 1) {
+	    if (idx >= vwords && carry == 0)
+		  break;
+	    res[idx] = add_carry(res[idx], idx < vwords? val[idx] : 0, carry);
+      }
 }
 
-static void div_mod (vvp_vector2_t dividend, vvp_vector2_t divisor,
-		     vvp_vector2_t&quotient, vvp_vector2_t&remainder)
+/*
+ * res -= val, where res has rwords words and res >= val.
+ */
+static void sub_from_words(unsigned long*res, unsigned rwords,
+			   const unsigned long*val, unsigned vwords)
 {
+      unsigned long carry = 1;
+      for (unsigned idx = 0 ;  idx < rwords ;  idx += 1) {
+	    if (idx >= vwords && carry == 1)
+		  break;
+	    res[idx] = add_carry(res[idx], idx < vwords? ~val[idx] : ~0UL, carry);
+      }
+}
 
-      quotient = vvp_vector2_t(0, dividend.size());
+/*
+ * Products of wide balanced operands are split in half, Karatsuba
+ * style, until the halves are small enough for the schoolbook
+ * method. This makes a full product of n words take about n**1.6
+ * word multiplies instead of n**2.
+ */
+static const unsigned KARATSUBA_WORDS = 32;
 
-      if (divisor == quotient) {
-	    cerr << "ERROR: division by zero, exiting." << endl;
-	    exit(255);
+static void mul_words_karatsuba(unsigned long*res, const unsigned long*a,
+				const unsigned long*b, unsigned n)
+{
+      if (n < KARATSUBA_WORDS) {
+	    mul_words_school(res, 2*n, a, n, b, n);
+	    return;
       }
 
-      if (dividend < divisor) {
-	    remainder = dividend;
+      unsigned lo = n / 2;
+      unsigned hi = n - lo;
+
+	// z0 = a0*b0 and z2 = a1*b1 go directly into the result.
+      mul_words_karatsuba(res, a, b, lo);
+      mul_words_karatsuba(res+2*lo, a+lo, b+lo, hi);
+
+	// z1 = (a0+a1)*(b0+b1) - z0 - z2
+      std::vector<unsigned long> sa (hi+1), sb (hi+1), z1 (2*hi+2);
+      sa[hi] = add_words(&sa[0], a+lo, hi, a, lo);
+      sb[hi] = add_words(&sb[0], b+lo, hi, b, lo);
+      mul_words_karatsuba(&z1[0], &sa[0], &sb[0], hi+1);
+      sub_from_words(&z1[0], 2*hi+2, res, 2*lo);
+      sub_from_words(&z1[0], 2*hi+2, res+2*lo, 2*hi);
+
+      add_into_words(res+lo, 2*n-lo, &z1[0], 2*hi+2);
+}
+
+void vvp_mul_words(unsigned long*res, unsigned rwords,
+		   const unsigned long*a, unsigned awords,
+		   const unsigned long*b, unsigned bwords)
+{
+	// Verilog values are often much wider than the numbers that
+	// they hold, so skip the leading zero words.
+      while (awords > 0 && a[awords-1] == 0)
+	    awords -= 1;
+      while (bwords > 0 && b[bwords-1] == 0)
+	    bwords -= 1;
+
+      unsigned n = awords > bwords? awords : bwords;
+      unsigned m = awords > bwords? bwords : awords;
+
+	// Karatsuba only pays when the full product is wanted and the
+	// operands are about the same size. Truncated products already
+	// skip the upper half in the schoolbook method.
+      if (n >= KARATSUBA_WORDS && 2*m > n && rwords >= awords+bwords) {
+	    std::vector<unsigned long> ta (n, 0), tb (n, 0), tr (2*n);
+	    for (unsigned idx = 0 ;  idx < awords ;  idx += 1)
+		  ta[idx] = a[idx];
+	    for (unsigned idx = 0 ;  idx < bwords ;  idx += 1)
+		  tb[idx] = b[idx];
+	    mul_words_karatsuba(&tr[0], &ta[0], &tb[0], n);
+	    for (unsigned idx = 0 ;  idx < rwords ;  idx += 1)
+		  res[idx] = idx < 2*n? tr[idx] : 0;
 	    return;
       }
 
-      vvp_vector2_t mask (1, dividend.size());
+      mul_words_school(res, rwords, a, awords, b, bwords);
+}
+
+/*
+ * This is Knuth's Algorithm D ("Seminumerical Algorithms", section
+ * 4.3.1), along the lines of the divmnu routine in "Hacker's Delight"
+ * by Henry S. Warren. The digits are half words, so that a two digit
+ * by one digit divide can be done with the native word divide.
+ */
+bool vvp_divmod_words(unsigned long*quot, unsigned long*rem,
+		      const unsigned long*a, const unsigned long*b,
+		      unsigned words)
+{
+      const unsigned HALF = 4 * sizeof(unsigned long);
+      const unsigned long BASE = 1UL << HALF;
+      const unsigned long MASK = BASE - 1;
+
+      const unsigned ndig = 2 * words;
+      std::vector<unsigned long> u (ndig+1), v (ndig+1);
+      for (unsigned idx = 0 ;  idx < words ;  idx += 1) {
+	    u[2*idx+0] = a[idx] & MASK;
+	    u[2*idx+1] = a[idx] >> HALF;
+	    v[2*idx+0] = b[idx] & MASK;
+	    v[2*idx+1] = b[idx] >> HALF;
+      }
+
+      unsigned m = ndig;
+      while (m > 0 && u[m-1] == 0)
+	    m -= 1;
+      unsigned n = ndig;
+      while (n > 0 && v[n-1] == 0)
+	    n -= 1;
+
+      if (n == 0)
+	    return false;
+
+      std::vector<unsigned long> q (ndig+1, 0), r (ndig+1, 0);
+
+      if (m < n) {
+	      // The divisor is larger then the dividend.
+	    for (unsigned idx = 0 ;  idx < m ;  idx += 1)
+		  r[idx] = u[idx];
 
-	// Make the dividend 1 bit larger to prevent overflow of
-	// divtmp in startup.
-      dividend = vvp_vector2_t(dividend, dividend.size()+1);
-      vvp_vector2_t divtmp (divisor, dividend.size());
+      } else if (n == 1) {
+	      // A single digit divisor is a simple short division.
+	    unsigned long k = 0;
+	    for (unsigned jdx = m ;  jdx > 0 ;  jdx -= 1) {
+		  unsigned long tmp = (k << HALF) | u[jdx-1];
+		  q[jdx-1] = tmp / v[0];
+		  k = tmp - q[jdx-1] * v[0];
+	    }
+	    r[0] = k;
+
+      } else {
+	      // Normalize so that the top digit of the divisor has
+	      // its high bit set. This keeps the estimated quotient
+	      // digit within 2 of the real digit.
+	    unsigned sh = 0;
+	    while ((v[n-1] << sh & (BASE >> 1)) == 0)
+		  sh += 1;
+
+	    std::vector<unsigned long> vn (n), un (m+1);
+	    for (unsigned idx = n-1 ;  idx > 0 ;  idx -= 1)
+		  vn[idx] = ((v[idx] << sh) | (v[idx-1] >> (HALF-sh))) & MASK;
+	    vn[0] = (v[0] << sh) & MASK;
+
+	    un[m] = u[m-1] >> (HALF-sh);
+	    for (unsigned idx = m-1 ;  idx > 0 ;  idx -= 1)
+		  un[idx] = ((u[idx] << sh) | (u[idx-1] >> (HALF-sh))) & MASK;
+	    un[0] = (u[0] << sh) & MASK;
+
+	    for (unsigned jdx = m-n+1 ;  jdx > 0 ;  jdx -= 1) {
+		  const unsigned j = jdx - 1;
+
+		    // Estimate the quotient digit from the top two
+		    // digits of the remainder, and correct the estimate
+		    // with the second divisor digit.
+		  unsigned long num = (un[j+n] << HALF) | un[j+n-1];
+		  unsigned long qhat = num / vn[n-1];
+		  unsigned long rhat = num - qhat * vn[n-1];
+		  while (qhat >= BASE
+			 || qhat * vn[n-2] > ((rhat << HALF) | un[j+n-2])) {
+			qhat -= 1;
+			rhat += vn[n-1];
+			if (rhat >= BASE)
+			      break;
+		  }
+
+		    // Multiply and subtract.
+		  long k = 0;
+		  long t;
+		  for (unsigned idx = 0 ;  idx < n ;  idx += 1) {
+			unsigned long p = qhat * vn[idx];
+			t = (long)un[idx+j] - k - (long)(p & MASK);
+			un[idx+j] = (unsigned long)t & MASK;
+			k = (long)(p >> HALF) - (t >> HALF);
+		  }
+		  t = (long)un[j+n] - k;
+		  un[j+n] = (unsigned long)t & MASK;
+
+		    // If the estimate was still one too large, then
+		    // add the divisor back in.
+		  q[j] = qhat;
+		  if (t < 0) {
+			q[j] -= 1;
+			unsigned long c = 0;
+			for (unsigned idx = 0 ;  idx < n ;  idx += 1) {
+			      unsigned long tmp = un[idx+j] + vn[idx] + c;
+			      un[idx+j] = tmp & MASK;
+			      c = tmp >> HALF;
+			}
+			un[j+n] = (un[j+n] + c) & MASK;
+		  }
+	    }
 
-      while (divtmp < dividend) {
-	    divtmp <<= 1;
-	    mask <<= 1;
+	      // Unnormalize the remainder.
+	    for (unsigned idx = 0 ;  idx < n-1 ;  idx += 1)
+		  r[idx] = ((un[idx] >> sh) | (un[idx+1] << (HALF-sh))) & MASK;
+	    r[n-1] = un[n-1] >> sh;
       }
 
-      while (dividend >= divisor) {
-	    if (divtmp <= dividend) {
-		  dividend -= divtmp;
-		  quotient += mask;
+	// The results are written last so that they may overlap the
+	// operands.
+      for (unsigned idx = 0 ;  idx < words ;  idx += 1) {
+	    if (quot) quot[idx] = q[2*idx+0] | (q[2*idx+1] << HALF);
+	    if (rem)  rem[idx]  = r[2*idx+0] | (r[2*idx+1] << HALF);
+      }
+
+      return true;
+}
+
+/*
+ * Multiplication of two vector2 vectors returns a product as wide as
+ * the sum of the widths of the input vectors.
+ */
+vvp_vector2_t operator * (const vvp_vector2_t&a, const vvp_vector2_t&b)
+{
+      const unsigned bits_per_word = 8 * sizeof(a.vec_[0]);
+      vvp_vector2_t r (0, a.size() + b.size());
+
+      unsigned awords = (a.wid_ + bits_per_word - 1) / bits_per_word;
+      unsigned bwords = (b.wid_ + bits_per_word - 1) / bits_per_word;
+      unsigned rwords = (r.wid_ + bits_per_word - 1) / bits_per_word;
+
+      if (rwords > 0)
+	    vvp_mul_words(r.vec_, rwords, a.vec_, awords, b.vec_, bwords);
+
+      return r;
+}
+
+/*
+ * Raise x to the power y by repeated squaring. Only the low wid bits
+ * of the result are wanted, so the intermediate products are kept to
+ * wid bits instead of being allowed to grow with the exponent.
+ */
+vvp_vector2_t pow(const vvp_vector2_t&x, const vvp_vector2_t&y, unsigned wid)
+{
+      const unsigned words = (wid + vvp_vector2_t::BITS_PER_WORD-1)
+			   / vvp_vector2_t::BITS_PER_WORD;
+
+      vvp_vector2_t res (1, wid);
+      if (words == 0)
+	    return res;
+
+      vvp_vector2_t base (x, wid);
+      std::vector<unsigned long> tmp (words);
+
+      unsigned ybits = y.size();
+      while (ybits > 0 && y.value(ybits-1) == 0)
+	    ybits -= 1;
+
+      for (unsigned idx = 0 ;  idx < ybits ;  idx += 1) {
+	    if (y.value(idx)) {
+		  vvp_mul_words(&tmp[0], words, res.vec_, words, base.vec_, words);
+		  for (unsigned wdx = 0 ;  wdx < words ;  wdx += 1)
+			res.vec_[wdx] = tmp[wdx];
+	    }
+	    if (idx+1 < ybits) {
+		  vvp_mul_words(&tmp[0], words, base.vec_, words, base.vec_, words);
+		  for (unsigned wdx = 0 ;  wdx < words ;  wdx += 1)
+			base.vec_[wdx] = tmp[wdx];
 	    }
+      }
+
+	// Cleanup the tail bits.
+      if (unsigned tail = wid % vvp_vector2_t::BITS_PER_WORD)
+	    res.vec_[words-1] &= -1UL >> (vvp_vector2_t::BITS_PER_WORD - tail);
 
-	    divtmp >>= 1;
-	    mask >>= 1;
+      return res;
+}
+
+void div_mod(const vvp_vector2_t&dividend, const vvp_vector2_t&divisor,
+	     vvp_vector2_t&quotient, vvp_vector2_t&remainder)
+{
+      const unsigned wid = dividend.size() > divisor.size()
+			 ? dividend.size() : divisor.size();
+      const unsigned words = (wid + vvp_vector2_t::BITS_PER_WORD-1)
+			   / vvp_vector2_t::BITS_PER_WORD;
+
+	// Both operands are extended to the same number of words.
+      vvp_vector2_t a (dividend, wid);
+      vvp_vector2_t b (divisor, wid);
+      std::vector<unsigned long> q (words+1), r (words+1);
+
+      if (words == 0 || ! vvp_divmod_words(&q[0], &r[0], a.vec_, b.vec_, words)) {
+	    cerr << "ERROR: division by zero, exiting." << endl;
+	    exit(255);
       }
 
-      remainder = vvp_vector2_t(dividend, mask.size());
+	// The quotient and the remainder are both no larger than the
+	// dividend, so they fit in its width.
+      quotient = vvp_vector2_t(0, dividend.size());
+      remainder = vvp_vector2_t(0, dividend.size());
+      const unsigned dwords = (dividend.size() + vvp_vector2_t::BITS_PER_WORD-1)
+			    / vvp_vector2_t::BITS_PER_WORD;
+      for (unsigned idx = 0 ;  idx < dwords ;  idx += 1) {
+	    quotient.vec_[idx] = q[idx];
+	    remainder.vec_[idx] = r[idx];
+      }
 }
 
 vvp_vector2_t operator - (const vvp_vector2_t&that)
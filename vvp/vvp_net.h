@@ -62,9 +62,9 @@ class  vvp_delay_t;
 
 /*
  * Storage for items declared in automatically allocated scopes (i.e. automatic
- * tasks and functions). The first two slots in each context are reserved for
- * linking to other contexts. The function that adds items to a context knows
- * this, and allocates context indices accordingly.
+ * tasks and functions). The first three slots in each context are reserved
+ * for linking to other contexts. The function that adds items to a context
+ * knows this, and allocates context indices accordingly.
  */
 typedef void**vvp_context_t;
 
@@ -72,7 +72,7 @@ typedef void*vvp_context_item_t;
 
 inline vvp_context_t vvp_allocate_context(unsigned nitem)
 {
-      return (vvp_context_t)malloc((2 + nitem) * sizeof(void*));
+      return (vvp_context_t)malloc((3 + nitem) * sizeof(void*));
 }
 
 inline vvp_context_t vvp_get_next_context(vvp_context_t context)
@@ -85,6 +85,20 @@ inline void vvp_set_next_context(vvp_context_t context, vvp_context_t next)
       context[0] = next;
 }
 
+/*
+ * The live contexts of a scope are also linked backwards, so that a
+ * context can be removed from the live list without searching for it.
+ */
+inline vvp_context_t vvp_get_prev_context(vvp_context_t context)
+{
+      return (vvp_context_t)context[2];
+}
+
+inline void vvp_set_prev_context(vvp_context_t context, vvp_context_t prev)
+{
+      context[2] = prev;
+}
+
 inline vvp_context_t vvp_get_stacked_context(vvp_context_t context)
 {
       return (vvp_context_t)context[1];
@@ -251,6 +265,9 @@ class vvp_vector4_t {
 	// array of longs, or a nil pointer if an XZ bit was detected
 	// in the array.
       unsigned long*subarray(unsigned idx, unsigned size) const;
+	// Same as above, but write the bits into the caller's array,
+	// which must be big enough. Return false if there are XZ bits.
+      bool subarray(unsigned long*val, unsigned idx, unsigned size) const;
       void setarray(unsigned idx, unsigned size, const unsigned long*val);
 
 	// Set a 4-value bit or subvector into the vector. Return true
@@ -266,6 +283,9 @@ class vvp_vector4_t {
 
 	// Test that the vectors are exactly equal
       bool eeq(const vvp_vector4_t&that) const;
+	// Test that the bits of this vector starting at the address
+	// are exactly equal to that vector. The part must fit.
+      bool eeq_part(unsigned adr, const vvp_vector4_t&that) const;
 
 	// Test that the vectors are equal, with xz comparing as equal.
       bool eq_xz(const vvp_vector4_t&that) const;
@@ -563,6 +583,13 @@ class vvp_vector4array_t {
 
 /*
  * Statically allocated vvp_vector4array_t
+ *
+ * The words are packed into pages, with the abits and bbits of each
+ * word next to each other. Small arrays are a single page that is
+ * allocated up front. Larger arrays allocate each page the first time
+ * a word in it is written, so that huge memories that are only
+ * sparsely used take little space. Reading a word from a page that
+ * was never written returns the initial X value.
  */
 class vvp_vector4array_sa : public vvp_vector4array_t {
 
@@ -574,7 +601,14 @@ class vvp_vector4array_sa : public vvp_vector4array_t {
       void set_word(unsigned idx, const vvp_vector4_t&that);
 
     private:
-      v4cell* array_;
+      unsigned long* alloc_page_(unsigned page);
+
+	// Number of unsigned longs for each of the abits/bbits of a word.
+      unsigned cnt_;
+	// Each page holds 1<<page_shift_ words.
+      unsigned page_shift_;
+      unsigned npages_;
+      unsigned long**pages_;
 };
 
 /*
@@ -608,6 +642,10 @@ class vvp_vector2_t {
 				       const vvp_vector2_t&);
       friend vvp_vector2_t operator * (const vvp_vector2_t&,
 				       const vvp_vector2_t&);
+      friend vvp_vector2_t pow(const vvp_vector2_t&, const vvp_vector2_t&,
+			       unsigned);
+      friend void div_mod(const vvp_vector2_t&, const vvp_vector2_t&,
+			  vvp_vector2_t&, vvp_vector2_t&);
       friend bool operator >  (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator >= (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator <  (const vvp_vector2_t&, const vvp_vector2_t&);
@@ -675,9 +713,26 @@ extern vvp_vector2_t operator * (const vvp_vector2_t&, const vvp_vector2_t&);
 extern vvp_vector2_t operator / (const vvp_vector2_t&, const vvp_vector2_t&);
 extern vvp_vector2_t operator % (const vvp_vector2_t&, const vvp_vector2_t&);
 
-vvp_vector2_t pow(const vvp_vector2_t&, vvp_vector2_t&);
+  // Return the low wid bits of x raised to the power y.
+extern vvp_vector2_t pow(const vvp_vector2_t&x, const vvp_vector2_t&y,
+			 unsigned wid);
 extern vvp_vector4_t vector2_to_vector4(const vvp_vector2_t&, unsigned wid);
 
+/*
+ * Word level arithmetic on arrays of unsigned long, least significant
+ * word first. vvp_mul_words writes the low rwords words of a*b into
+ * res, which must not overlap a or b. vvp_divmod_words divides a by b,
+ * where both have the given number of words, and writes the quotient
+ * and remainder (either may be nil) which may overlap the inputs. It
+ * returns false if b is zero.
+ */
+extern void vvp_mul_words(unsigned long*res, unsigned rwords,
+			  const unsigned long*a, unsigned awords,
+			  const unsigned long*b, unsigned bwords);
+extern bool vvp_divmod_words(unsigned long*quot, unsigned long*rem,
+			     const unsigned long*a, const unsigned long*b,
+			     unsigned words);
+
 /* A c4string is of the form C4<...> where ... are bits. */
 extern bool c4string_test(const char*str);
 extern vvp_vector4_t c4string_to_vector4(const char*str);
@@ -1101,9 +1156,31 @@ class vvp_net_t {
     public: // Method to support $countdrivers
       void count_drivers(unsigned idx, unsigned counts[4]);
 
+	// The compiler calls this when all the nets are linked. After
+	// that, nets copy their fanout into arrays as they are used.
+      static void fanout_ready();
+
     private:
       vvp_net_ptr_t out_;
 
+	// Once linking is done, the fanout chain that starts at out_
+	// is copied into this nil terminated array the first time the
+	// net sends a value, so that sends scan the array instead of
+	// chasing the chain through the port[] of each receiver. Nets
+	// with fewer than two receivers, and nets whose fanout changes
+	// after the array is made, point this at fanout_chain_ and
+	// keep using the chain.
+      vvp_net_ptr_t*fanout_;
+      vvp_net_ptr_t* fanout_array_();
+      void make_fanout_();
+
+      void out_vec4_(const vvp_vector4_t&val, vvp_context_t context);
+      void out_vec8_(const vvp_vector8_t&val);
+      void out_real_(double val, vvp_context_t context);
+
+      static bool fanout_ready_;
+      static vvp_net_ptr_t fanout_chain_[1];
+
     public: // Need a better new for these objects.
       static void* operator new(std::size_t size);
       static void operator delete(void*); // not implemented
@@ -1524,10 +1601,27 @@ class vvp_wide_fun_t : public vvp_net_fun_t {
 };
 
 
+/*
+ * The nets of a fanout chain are wherever the loader happened to
+ * allocate them, so walking the chain jumps around the heap. The send
+ * loops ask for the next net of the chain to be fetched into the
+ * cache while the current net runs its functor. Compile with
+ * VVP_NO_PREFETCH defined to compare against the plain walk.
+ */
+inline void vvp_prefetch_net(const vvp_net_t*net)
+{
+#if defined(__GNUC__) && !defined(VVP_NO_PREFETCH)
+      __builtin_prefetch(net);
+#else
+      (void)net;
+#endif
+}
+
 inline void vvp_send_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&val, vvp_context_t context)
 {
       while (class vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_vec4(ptr, val, context);
@@ -1536,9 +1630,31 @@ inline void vvp_send_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&val, vvp_contex
       }
 }
 
+/*
+ * These deliver a value to all the receivers in a nil terminated
+ * fanout array.
+ */
+inline void vvp_send_vec4_fanout(vvp_net_ptr_t*fan,
+				 const vvp_vector4_t&val,
+				 vvp_context_t context)
+{
+      while (class vvp_net_t*cur = fan->ptr()) {
+	    vvp_prefetch_net(fan[1].ptr());
+
+	    if (cur->fun)
+		  cur->fun->recv_vec4(*fan, val, context);
+
+	    fan += 1;
+      }
+}
+
 extern void vvp_send_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&val);
 extern void vvp_send_real(vvp_net_ptr_t ptr, double val,
                           vvp_context_t context);
+extern void vvp_send_vec8_fanout(vvp_net_ptr_t*fan,
+				 const vvp_vector8_t&val);
+extern void vvp_send_real_fanout(vvp_net_ptr_t*fan, double val,
+				 vvp_context_t context);
 extern void vvp_send_long(vvp_net_ptr_t ptr, long val);
 extern void vvp_send_long_pv(vvp_net_ptr_t ptr, long val,
                              unsigned base, unsigned width);
@@ -1547,6 +1663,7 @@ inline void vvp_send_string(vvp_net_ptr_t ptr, const std::string&val, vvp_contex
 {
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_string(ptr, val, context);
@@ -1559,6 +1676,7 @@ inline void vvp_send_object(vvp_net_ptr_t ptr, vvp_object_t val, vvp_context_t c
 {
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_object(ptr, val, context);
@@ -1592,6 +1710,7 @@ inline void vvp_send_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&val,
 {
       while (class vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_vec4_pv(ptr, val, base, wid, vwid, context);
@@ -1605,6 +1724,7 @@ inline void vvp_send_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&val,
 {
       while (class vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next = cur->port[ptr.port()];
+	    vvp_prefetch_net(next.ptr());
 
 	    if (cur->fun)
 		  cur->fun->recv_vec8_pv(ptr, val, base, wid, vwid);
@@ -1613,10 +1733,43 @@ inline void vvp_send_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&val,
       }
 }
 
+inline vvp_net_ptr_t* vvp_net_t::fanout_array_()
+{
+      if (fanout_ == 0)
+	    make_fanout_();
+      if (fanout_ == fanout_chain_)
+	    return 0;
+      return fanout_;
+}
+
+inline void vvp_net_t::out_vec4_(const vvp_vector4_t&val, vvp_context_t context)
+{
+      if (vvp_net_ptr_t*fan = fanout_array_())
+	    vvp_send_vec4_fanout(fan, val, context);
+      else
+	    vvp_send_vec4(out_, val, context);
+}
+
+inline void vvp_net_t::out_vec8_(const vvp_vector8_t&val)
+{
+      if (vvp_net_ptr_t*fan = fanout_array_())
+	    vvp_send_vec8_fanout(fan, val);
+      else
+	    vvp_send_vec8(out_, val);
+}
+
+inline void vvp_net_t::out_real_(double val, vvp_context_t context)
+{
+      if (vvp_net_ptr_t*fan = fanout_array_())
+	    vvp_send_real_fanout(fan, val, context);
+      else
+	    vvp_send_real(out_, val, context);
+}
+
 inline void vvp_net_t::send_vec4(const vvp_vector4_t&val, vvp_context_t context)
 {
       if (fil == 0) {
-	    vvp_send_vec4(out_, val, context);
+	    out_vec4_(val, context);
 	    return;
       }
 
@@ -1625,10 +1778,10 @@ inline void vvp_net_t::send_vec4(const vvp_vector4_t&val, vvp_context_t context)
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec4(out_, val, context);
+	    out_vec4_(val, context);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec4(out_, rep, context);
+	    out_vec4_(rep, context);
 	    break;
       }
 }
@@ -1659,7 +1812,7 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
 inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 {
       if (fil == 0) {
-	    vvp_send_vec8(out_, val);
+	    out_vec8_(val);
 	    return;
       }
 
@@ -1668,10 +1821,10 @@ inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec8(out_, val);
+	    out_vec8_(val);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec8(out_, rep);
+	    out_vec8_(rep);
 	    break;
       }
 }
@@ -1703,7 +1856,7 @@ inline void vvp_net_t::send_real(double val, vvp_context_t context)
       if (fil && ! fil->filter_real(val))
 	    return;
 
-      vvp_send_real(out_, val, context);
+      out_real_(val, context);
 }
 
 